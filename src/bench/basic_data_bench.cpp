@@ -0,0 +1,94 @@
+/**
+ * File: basic_data_bench.cpp
+ * 
+ * Measures construction and copy throughput of dht::key and 
+ * dht::value with payloads of different sizes. For comparison the
+ * same is run against a class that keeps its data in a std::string,
+ * which is how basic_data stored data before small payloads were
+ * kept inside the object.
+ * 
+ * Usage: basic_data_bench [operations]
+ * 
+ * Output is one line per type, operation and payload size, 
+ * for example:
+ * type=key op=copy size=16 ops=1000000 seconds=0.012 ops_per_sec=83333333
+ */
+#include <ace/OS_NS_sys_time.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include "dht/key.h"
+#include "dht/value.h"
+
+// basic_data before inline storage
+class string_data {
+    std::string _data;
+    bool        _allow_hash_transform;
+public:
+    string_data(const char *str) : _data(str), _allow_hash_transform(true) {}
+    virtual ~string_data() {}
+    size_t size() const { return _data.size(); }
+};
+
+static double
+seconds_since(const ACE_Time_Value &start) {
+    ACE_Time_Value d = ACE_OS::gettimeofday() - start;
+    return d.sec() + d.usec() / 1000000.0;
+}
+
+static void
+report(const char *type, const char *op, size_t size, size_t ops, 
+       double seconds) 
+{
+    printf("type=%s op=%s size=%lu ops=%lu seconds=%.3f "
+           "ops_per_sec=%.0f\n",
+           type, op, (unsigned long)size, (unsigned long)ops, seconds,
+           seconds > 0 ? ops / seconds : 0.0);
+}
+
+// Constructs from a C string and copies the objects in batches, 
+// as when keys and values are passed to tasks and messages
+template <class Data>
+static void
+run(const char *type, size_t size, size_t ops) {
+    const size_t batch = 1000;
+    std::string  payload(size, 'x');
+    size_t       total = 0;
+    
+    std::vector<Data> src;
+    src.reserve(batch);
+    ACE_Time_Value start = ACE_OS::gettimeofday();
+    for (size_t done = 0; done < ops; done += batch) {
+        src.clear();
+        for (size_t i = 0; i < batch; i++) 
+            src.push_back(Data(payload.c_str()));
+        total += src.back().size();
+    }
+    report(type, "construct", size, ops, seconds_since(start));
+    
+    start = ACE_OS::gettimeofday();
+    for (size_t done = 0; done < ops; done += batch) {
+        std::vector<Data> copy(src);
+        total += copy.back().size();
+    }
+    report(type, "copy", size, ops, seconds_since(start));
+    
+    if (total == 1) printf("\n"); // keep the loops
+}
+
+int
+main(int argc, char *argv[]) {
+    size_t ops = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+    const size_t sizes[] = { 8, 16, 32, 64, 256 };
+    
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        run<string_data>("string", sizes[i], ops);
+        run<dht::key>   ("key",    sizes[i], ops);
+        run<dht::value> ("value",  sizes[i], ops);
+    }
+    return 0;
+}
@@ -0,0 +1,329 @@
+/**
+ * File: dht_bench.cpp
+ * 
+ * Load generator for dht::client implementations. Keeps up to
+ * 'concurrency' finds and stores running against the chosen backend,
+ * starting new ones at 'rate' operations per second (or as fast as 
+ * they complete if rate is 0).
+ * 
+ * Usage: dht_bench [name=value ...]
+ * 
+ * Options (defaults in parentheses):
+ * - backend:     sim or kadc (sim)
+ * - ops:         number of measured operations (1000)
+ * - concurrency: maximum number of operations running at once (16)
+ * - rate:        operations started per second, 0 for unlimited (0)
+ * - store_ratio: fraction of operations that are stores (0.5)
+ * - keys:        number of different keys used (100)
+ * - value_size:  size of stored values in bytes (64)
+ * - preload:     if 1, every key is stored once before measuring (1)
+ * All options are also passed to the client's init(), for example
+ * latency=20 for sim or init_file=kadc.ini for kadc.
+ * 
+ * Output is one line per operation type plus one for the process,
+ * for example:
+ * op=find backend=sim count=500 failures=0 seconds=2.051 ops_per_sec=243.8 
+ *   latency_p50_ms=50.1 latency_p99_ms=50.9 latency_p999_ms=51.0
+ *   first_hit_p50_ms=50.1 first_hit_p99_ms=50.9 hits=1000
+ * process peak_rss_kb=4120
+ */
+#include <ace/OS_NS_stdlib.h>
+#include <ace/OS_NS_sys_time.h>
+
+#include <sys/resource.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "dht/client.h"
+#include "dht/kadc/client.h"
+#include "dht/sim/client.h"
+
+static const char *usage = 
+"Usage: dht_bench [backend=sim|kadc] [ops=N] [concurrency=N] [rate=N]\n"
+"                 [store_ratio=F] [keys=N] [value_size=N] [preload=0|1]\n"
+"                 [client_option=value ...]\n";
+
+static dht::client *dht_client = NULL;
+
+static long long
+now_usec() {
+    ACE_Time_Value t = ACE_OS::gettimeofday();
+    return (long long)t.sec() * 1000000 + t.usec();
+}
+
+// Handler for one find or store operation
+class bench_op : public dht::search_handler {
+public:
+    bool      store;
+    bool      done;
+    bool      failed;
+    long      hits;
+    long long started;
+    long long first_hit;
+    long long finished;
+    
+    bench_op(bool is_store) 
+      : store(is_store), done(false), failed(false), hits(0),
+        started(now_usec()), first_hit(0), finished(0) {}
+    
+    virtual int found(const dht::key &, const dht::value &) {
+        if (hits++ == 0) first_hit = now_usec();
+        return 0;
+    }
+    virtual void success(const dht::key &) { _finish(false); }
+    virtual void failure(const dht::key &, int, const char *) { 
+        _finish(true); 
+    }
+    virtual void success() { _finish(false); }
+    virtual void failure(int, const char *) { _finish(true); }
+private:
+    void _finish(bool f) {
+        failed   = f;
+        done     = true;
+        finished = now_usec();
+    }
+};
+
+struct op_stats {
+    long               count;
+    long               failures;
+    long               hits;
+    std::vector<long long> latencies;
+    std::vector<long long> first_hits;
+    
+    op_stats() : count(0), failures(0), hits(0) {}
+    
+    void add(const bench_op *op) {
+        count++;
+        if (op->failed) failures++;
+        hits += op->hits;
+        latencies.push_back(op->finished - op->started);
+        if (op->hits) first_hits.push_back(op->first_hit - op->started);
+    }
+};
+
+// Returns the given percentile in milliseconds, sorts v
+static double
+percentile_ms(std::vector<long long> &v, double p) {
+    if (v.empty()) return 0.0;
+    std::sort(v.begin(), v.end());
+    size_t i = (size_t)(p * (v.size() - 1) + 0.5);
+    return v[i] / 1000.0;
+}
+
+static void
+report(const char *op, const char *backend, op_stats &s, double secs) {
+    printf("op=%s backend=%s count=%ld failures=%ld seconds=%.3f "
+           "ops_per_sec=%.1f latency_p50_ms=%.3f latency_p99_ms=%.3f "
+           "latency_p999_ms=%.3f", 
+           op, backend, s.count, s.failures, secs, 
+           secs > 0.0 ? s.count / secs : 0.0,
+           percentile_ms(s.latencies, 0.50),
+           percentile_ms(s.latencies, 0.99),
+           percentile_ms(s.latencies, 0.999));
+    if (strcmp(op, "store") != 0) {
+        printf(" first_hit_p50_ms=%.3f first_hit_p99_ms=%.3f hits=%ld", 
+               percentile_ms(s.first_hits, 0.50),
+               percentile_ms(s.first_hits, 0.99),
+               s.hits);
+    }
+    printf("\n");
+}
+
+static long
+peak_rss_kb() {
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0) return -1;
+    return ru.ru_maxrss;
+}
+
+static void
+process_for(long long usec) {
+    if (usec < 0) usec = 0;
+    ACE_Time_Value wait(0, (long)usec);
+    dht_client->process(wait);
+}
+
+static bool
+wait_state(int state) {
+    while (dht_client->in_state() != state) {
+        if (dht_client->in_state() == dht::client::disconnected) 
+            return false;
+        process_for(100 * 1000);
+    }
+    return true;
+}
+
+static std::string
+key_name(long i) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "dht_bench_%ld", i);
+    return buf;
+}
+
+// Runs ops operations and adds their results to finds and stores.
+// If preload_keys is non-zero, stores each key once instead.
+static void
+run(long ops, long concurrency, double rate, double store_ratio,
+    long keys, const dht::value &val, long preload_keys,
+    op_stats *finds, op_stats *stores)
+{
+    std::vector<bench_op *> running;
+    long started = 0, completed = 0;
+    long long begin = now_usec();
+    unsigned int seed = 1;
+    
+    if (preload_keys) ops = preload_keys;
+    
+    while (completed < ops) {
+        // Start new operations when allowed by concurrency and rate
+        long long next_start = 0;
+        while (started < ops && (long)running.size() < concurrency) {
+            if (rate > 0.0) {
+                next_start = begin + (long long)(started * 1000000.0 / rate);
+                if (next_start > now_usec()) break;
+            }
+            bool is_store = preload_keys ? true :
+                ACE_OS::rand_r(&seed) < store_ratio * ((double)RAND_MAX + 1.0);
+            long k = preload_keys ? started : ACE_OS::rand_r(&seed) % keys;
+            
+            bench_op *op = new bench_op(is_store);
+            running.push_back(op);
+            started++;
+            if (is_store) dht_client->store(key_name(k), val, op);
+            else          dht_client->find(key_name(k), op);
+        }
+        
+        long long wait = 10 * 1000;
+        if (rate > 0.0 && started < ops && 
+            (long)running.size() < concurrency) 
+        {
+            wait = std::min(wait, next_start - now_usec());
+        }
+        process_for(wait);
+        
+        // Handlers are never deleted from within their callbacks
+        for (size_t i = 0; i < running.size(); ) {
+            bench_op *op = running[i];
+            if (!op->done) { i++; continue; }
+            if (op->store) { if (stores) stores->add(op); }
+            else           { if (finds)  finds->add(op);  }
+            delete op;
+            running[i] = running.back();
+            running.pop_back();
+            completed++;
+        }
+        
+        if (dht_client->in_state() != dht::client::connected) {
+            fprintf(stderr, "dht_bench: client no longer connected\n");
+            break;
+        }
+    }
+    for (size_t i = 0; i < running.size(); i++) {
+        dht_client->handler_cancel(running[i]);
+        delete running[i];
+    }
+}
+
+static long
+opt_long(const dht::name_value_map &opts, const char *name, long def) {
+    if (!opts.exists(name)) return def;
+    long v = strtol(opts.get(name).c_str(), NULL, 10);
+    return v;
+}
+
+static double
+opt_double(const dht::name_value_map &opts, const char *name, double def) {
+    if (!opts.exists(name)) return def;
+    double v = strtod(opts.get(name).c_str(), NULL);
+    return v;
+}
+
+int
+ACE_TMAIN (int argc, ACE_TCHAR *argv[])
+{
+    dht::name_value_map opts;
+    for (int i = 1; i < argc; i++) {
+        const char *eq = strchr(argv[i], '=');
+        if (eq == NULL) {
+            fprintf(stderr, "%s", usage);
+            return 1;
+        }
+        opts.set(std::string(argv[i], eq - argv[i]), eq + 1);
+    }
+    
+    std::string backend = opts.get("backend", "sim");
+    long   ops         = opt_long(opts,   "ops",         1000);
+    long   concurrency = opt_long(opts,   "concurrency", 16);
+    double rate        = opt_double(opts, "rate",        0.0);
+    double store_ratio = opt_double(opts, "store_ratio", 0.5);
+    long   keys        = opt_long(opts,   "keys",        100);
+    long   value_size  = opt_long(opts,   "value_size",  64);
+    long   preload     = opt_long(opts,   "preload",     1);
+    
+    if (ops <= 0 || concurrency <= 0 || keys <= 0 || value_size < 0) {
+        fprintf(stderr, "%s", usage);
+        return 1;
+    }
+    
+    try {
+        if (backend == "sim") {
+            dht_client = new dht::sim::client;
+        } else if (backend == "kadc") {
+            dht_client = new dht::kadc::client;
+            if (!opts.exists("init_file")) opts.set("init_file", "kadc.ini");
+        } else {
+            fprintf(stderr, "dht_bench: unknown backend %s\n", 
+                    backend.c_str());
+            return 1;
+        }
+        dht_client->init(opts);
+        
+        dht_client->connect();
+        if (!wait_state(dht::client::connected)) {
+            fprintf(stderr, "dht_bench: could not connect\n");
+            delete dht_client;
+            return 1;
+        }
+        
+        std::string data((size_t)value_size, 'v');
+        dht::value val(data);
+        if (preload) {
+            run(0, concurrency, 0.0, 1.0, keys, val, keys, NULL, NULL);
+        }
+        
+        op_stats finds, stores, all;
+        long long begin = now_usec();
+        run(ops, concurrency, rate, store_ratio, keys, val, 0, 
+            &finds, &stores);
+        double secs = (now_usec() - begin) / 1000000.0;
+        
+        all.count    = finds.count + stores.count;
+        all.failures = finds.failures + stores.failures;
+        all.hits     = finds.hits;
+        all.latencies = finds.latencies;
+        all.latencies.insert(all.latencies.end(), stores.latencies.begin(),
+                             stores.latencies.end());
+        all.first_hits = finds.first_hits;
+        
+        report("find",  backend.c_str(), finds,  secs);
+        report("store", backend.c_str(), stores, secs);
+        report("all",   backend.c_str(), all,    secs);
+        printf("process peak_rss_kb=%ld\n", peak_rss_kb());
+        
+        if (dht_client->in_state() == dht::client::connected) {
+            dht_client->disconnect();
+            wait_state(dht::client::disconnected);
+        }
+        delete dht_client;
+    } catch (std::exception &e) {
+        fprintf(stderr, "dht_bench: exception %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,126 @@
+/**
+ * File: key_index_bench.cpp
+ * 
+ * Measures the cost of preparing the KadC index of a key for one
+ * find or store: hashing the key, looking the index up in a map the
+ * way the result cache and running searches are looked up, and
+ * producing the "#" prefixed hex string given to KadC.
+ * 
+ * path=string is how indexes were prepared before key128: the hash
+ * was formatted with int128sprintf into a std::string, which was
+ * also used as the map key. path=key128 keeps the hash binary and
+ * formats it only for the KadC call, into a stack buffer.
+ * path=digest is the same with the digest cached in the dht::key,
+ * as when the same keys are stored or searched again.
+ * 
+ * Usage: key_index_bench [operations] [keys]
+ * 
+ * Output is one line per path, for example:
+ * path=key128 ops=1000000 keys=1000 seconds=0.412 ns_per_op=412.0
+ */
+#include <ace/OS_NS_sys_time.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "dht/key.h"
+#include "dht/kadc/key128.h"
+#include "dht/kadc/util.h"
+
+using dht::kadc::key128;
+
+static double
+seconds_since(const ACE_Time_Value &start) {
+    ACE_Time_Value d = ACE_OS::gettimeofday() - start;
+    return d.sec() + d.usec() / 1000000.0;
+}
+
+// How the index was prepared before key128
+static void
+string_index(std::string *result, const dht::key &k) {
+    unsigned char h[16];
+    char kadch[33];
+    MD4(h, (unsigned char *)k.data(), k.size());
+    int128sprintf(kadch, h);
+    *result  = "#";
+    *result += kadch;
+}
+
+static void
+report(const char *path, size_t ops, size_t keys, double seconds,
+       size_t found) 
+{
+    printf("path=%s ops=%lu keys=%lu seconds=%.3f ns_per_op=%.1f "
+           "found=%lu\n",
+           path, (unsigned long)ops, (unsigned long)keys, seconds,
+           seconds * 1e9 / ops, (unsigned long)found);
+}
+
+int
+main(int argc, char *argv[]) {
+    size_t ops  = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+    size_t nkey = argc > 2 ? strtoul(argv[2], NULL, 10) : 1000;
+    if (nkey == 0) nkey = 1;
+    
+    std::vector<dht::key> keys;
+    char buf[64];
+    for (size_t i = 0; i < nkey; i++) {
+        snprintf(buf, sizeof(buf), "bench://key/%lu", (unsigned long)i);
+        keys.push_back(dht::key(buf));
+    }
+    
+    // Half of the keys are in the maps, as if cached or running
+    std::map<std::string, int> string_map;
+    std::map<key128, int>      key128_map;
+    for (size_t i = 0; i < nkey; i += 2) {
+        std::string s;
+        key128      k;
+        string_index(&s, keys[i]);
+        dht::kadc::util::kadc_hash(&k, keys[i].data(), keys[i].size(), 
+                                   true);
+        string_map[s] = 1;
+        key128_map[k] = 1;
+    }
+    
+    size_t         found = 0;
+    ACE_Time_Value start = ACE_OS::gettimeofday();
+    for (size_t i = 0; i < ops; i++) {
+        std::string s;
+        string_index(&s, keys[i % nkey]);
+        if (string_map.find(s) != string_map.end()) found++;
+        // The string was passed to KadC as such
+        if (s[1] == 'x') found++;
+    }
+    report("string", ops, nkey, seconds_since(start), found);
+    
+    found = 0;
+    start = ACE_OS::gettimeofday();
+    for (size_t i = 0; i < ops; i++) {
+        const dht::key &k = keys[i % nkey];
+        key128 index;
+        dht::kadc::util::kadc_hash(&index, k.data(), k.size(), true);
+        if (key128_map.find(index) != key128_map.end()) found++;
+        char kindex[key128::kadc_index_size];
+        index.kadc_index(kindex);
+        if (kindex[1] == 'x') found++;
+    }
+    report("key128", ops, nkey, seconds_since(start), found);
+    
+    found = 0;
+    start = ACE_OS::gettimeofday();
+    for (size_t i = 0; i < ops; i++) {
+        key128 index;
+        dht::kadc::util::kadc_hash(&index, keys[i % nkey]);
+        if (key128_map.find(index) != key128_map.end()) found++;
+        char kindex[key128::kadc_index_size];
+        index.kadc_index(kindex);
+        if (kindex[1] == 'x') found++;
+    }
+    report("digest", ops, nkey, seconds_since(start), found);
+    
+    return 0;
+}
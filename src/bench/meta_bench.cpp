@@ -0,0 +1,128 @@
+/**
+ * File: meta_bench.cpp
+ * 
+ * Measures filling the meta data of search results the way 
+ * dht::kadc::util::kadc_result does it for each hit: the 16 byte
+ * value is set and each KadC tag is set to the meta data from C
+ * strings. Each search has 500 hits, and the results are also
+ * copied once, as when they are put to the result cache.
+ * 
+ * For comparison the same is done with a value that keeps its data
+ * in a std::string and its meta data in a std::map of std::strings,
+ * which is how dht::value and dht::name_value_map were before.
+ * The flat map saves the tree nodes, but its names and values are
+ * still std::strings, so tags longer than the library's short string
+ * buffer are allocated in both.
+ * 
+ * Usage: meta_bench [searches] [tags]
+ * 
+ * Output is one line per implementation and operation, for example:
+ * meta=flat op=fill searches=1000 hits=500 tags=4 seconds=0.201 ns_per_hit=402.0
+ */
+#include <ace/OS_NS_sys_time.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "dht/value.h"
+
+// dht::value before flat meta data and inline storage of small data
+struct map_value {
+    std::string                        data;
+    std::map<std::string, std::string> meta;
+    
+    void set(const void *d, size_t len) { 
+        data.assign((const char *)d, len); 
+    }
+    void meta_set(const char *name, const char *value) {
+        meta[name] = value;
+    }
+};
+
+struct flat_value : public dht::value {
+    void meta_set(const char *name, const char *value) {
+        meta().set(name, value);
+    }
+};
+
+struct tag {
+    const char *name;
+    const char *value;
+};
+
+// Typical tags of a KadC keyword search hit
+static const tag tags[] = {
+    { "filename", "some_file_name.txt" },
+    { "size",     "1048576" },
+    { "type",     "Doc" },
+    { "format",   "txt" },
+    { "artist",   "an artist with a long name" },
+    { "album",    "album" },
+    { "title",    "title" },
+    { "bitrate",  "128" },
+};
+
+static double
+seconds_since(const ACE_Time_Value &start) {
+    ACE_Time_Value d = ACE_OS::gettimeofday() - start;
+    return d.sec() + d.usec() / 1000000.0;
+}
+
+static void
+report(const char *meta, const char *op, size_t searches, size_t hits,
+       size_t ntags, double seconds) 
+{
+    printf("meta=%s op=%s searches=%lu hits=%lu tags=%lu seconds=%.3f "
+           "ns_per_hit=%.1f\n",
+           meta, op, (unsigned long)searches, (unsigned long)hits, 
+           (unsigned long)ntags, seconds, 
+           seconds * 1e9 / (searches * hits));
+}
+
+template <class Value>
+static void
+run(const char *meta, size_t searches, size_t ntags) {
+    const size_t        hits = 500;
+    const unsigned char vhash[16] = { 1, 2, 3, 4, 5, 6, 7, 8, 
+                                      9, 10, 11, 12, 13, 14, 15, 16 };
+    double fill = 0, copy = 0;
+    size_t total = 0;
+    
+    for (size_t s = 0; s < searches; s++) {
+        ACE_Time_Value start = ACE_OS::gettimeofday();
+        std::vector<Value> results;
+        results.reserve(hits);
+        for (size_t h = 0; h < hits; h++) {
+            results.push_back(Value());
+            Value &v = results.back();
+            v.set(vhash, sizeof(vhash));
+            for (size_t t = 0; t < ntags; t++)
+                v.meta_set(tags[t].name, tags[t].value);
+        }
+        fill += seconds_since(start);
+        
+        start = ACE_OS::gettimeofday();
+        std::vector<Value> cached(results);
+        copy += seconds_since(start);
+        total += cached.size();
+    }
+    report(meta, "fill", searches, hits, ntags, fill);
+    report(meta, "copy", searches, hits, ntags, copy);
+    if (total == 1) printf("\n"); // keep the loops
+}
+
+int
+main(int argc, char *argv[]) {
+    size_t searches = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000;
+    size_t ntags    = argc > 2 ? strtoul(argv[2], NULL, 10) : 4;
+    if (ntags > sizeof(tags) / sizeof(tags[0])) 
+        ntags = sizeof(tags) / sizeof(tags[0]);
+    
+    run<map_value> ("map",  searches, ntags);
+    run<flat_value>("flat", searches, ntags);
+    return 0;
+}
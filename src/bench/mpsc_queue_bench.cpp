@@ -0,0 +1,131 @@
+/**
+ * File: mpsc_queue_bench.cpp
+ * 
+ * Measures throughput of the queue that carries messages from 
+ * KadC threads to the reactor thread (dht::kadc::mpsc_queue). 
+ * 1 to 32 producer threads push messages while one consumer
+ * thread pops them. For comparison the same load is run against
+ * a mutex protected std::queue, which is what the client used before.
+ * 
+ * The consumer also checks that messages of each producer are
+ * received in the order they were pushed.
+ * 
+ * Usage: mpsc_queue_bench [total_messages]
+ * 
+ * Output is one line per queue type and producer count, for example:
+ * queue=mpsc producers=4 messages=2000000 seconds=0.412 msgs_per_sec=4854368
+ */
+#include <ace/Thread_Manager.h>
+#include <ace/Thread_Mutex.h>
+#include <ace/Guard_T.h>
+#include <ace/OS_NS_sys_time.h>
+#include <ace/OS_NS_Thread.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <queue>
+#include <vector>
+
+#include "dht/kadc/mpsc_queue.h"
+
+struct bench_msg : public dht::kadc::mpsc_node {
+    int  producer;
+    long seq;
+};
+
+// Queue used by the client before mpsc_queue
+class locked_queue {
+    std::queue<bench_msg *> _q;
+    ACE_Thread_Mutex        _m;
+public:
+    void push(bench_msg *m) {
+        ACE_Guard<ACE_Thread_Mutex> guard(_m);
+        _q.push(m);
+    }
+    bench_msg *pop() {
+        ACE_Guard<ACE_Thread_Mutex> guard(_m);
+        if (_q.empty()) return NULL;
+        bench_msg *m = _q.front();
+        _q.pop();
+        return m;
+    }
+};
+
+template <class Queue>
+struct producer_ctx {
+    Queue     *queue;
+    bench_msg *msgs;
+    long       count;
+};
+
+template <class Queue>
+ACE_THR_FUNC_RETURN
+producer(void *arg) {
+    producer_ctx<Queue> *ctx = static_cast<producer_ctx<Queue> *>(arg);
+    for (long i = 0; i < ctx->count; i++)
+        ctx->queue->push(&ctx->msgs[i]);
+    return 0;
+}
+
+template <class Queue>
+bool 
+run(const char *name, int nproducers, long total) {
+    Queue queue;
+    long  per_producer = total / nproducers;
+    
+    // Messages are allocated beforehand so that only the queue is measured
+    std::vector<bench_msg>                   msgs(per_producer * nproducers);
+    std::vector<producer_ctx<Queue> >        ctxs(nproducers);
+    std::vector<long>                        last_seq(nproducers, -1);
+    for (int p = 0; p < nproducers; p++) {
+        ctxs[p].queue = &queue;
+        ctxs[p].msgs  = &msgs[p * per_producer];
+        ctxs[p].count = per_producer;
+        for (long i = 0; i < per_producer; i++) {
+            ctxs[p].msgs[i].producer = p;
+            ctxs[p].msgs[i].seq      = i;
+        }
+    }
+    
+    ACE_Time_Value start = ACE_OS::gettimeofday();
+    for (int p = 0; p < nproducers; p++) {
+        ACE_Thread_Manager::instance()->spawn(producer<Queue>, &ctxs[p]);
+    }
+    
+    bool ordered  = true;
+    long received = 0;
+    while (received < per_producer * nproducers) {
+        bench_msg *m = queue.pop();
+        if (m == NULL) {
+            ACE_OS::thr_yield();
+            continue;
+        }
+        if (m->seq != last_seq[m->producer] + 1) ordered = false;
+        last_seq[m->producer] = m->seq;
+        received++;
+    }
+    ACE_Time_Value elapsed = ACE_OS::gettimeofday() - start;
+    ACE_Thread_Manager::instance()->wait();
+    
+    double secs = elapsed.sec() + elapsed.usec() / 1000000.0;
+    printf("queue=%s producers=%d messages=%ld seconds=%.3f " \
+           "msgs_per_sec=%.0f%s\n",
+           name, nproducers, received, secs, 
+           secs > 0 ? received / secs : 0.0,
+           ordered ? "" : " ERROR=order");
+    return ordered;
+}
+
+int
+ACE_TMAIN(int argc, ACE_TCHAR *argv[]) {
+    long total = 2000000;
+    if (argc > 1) total = atol(argv[1]);
+    
+    bool ok = true;
+    for (int p = 1; p <= 32; p *= 2) {
+        ok = run<dht::kadc::mpsc_queue<bench_msg> >("mpsc",   p, total) && ok;
+        ok = run<locked_queue>                      ("locked", p, total) && ok;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,122 @@
+/**
+ * File: task_pool_bench.cpp
+ *
+ * Measures how long interactive finds wait for a worker of the
+ * KadC client's task pool (dht::kadc::task_pool) while the pool is
+ * busy with a burst of background stores. The operations are
+ * simulated by tasks that sleep, a store 50 ms and a find 5 ms.
+ *
+ * All the stores are queued first, then one find is queued every
+ * 2 ms. With mode=fifo every task has the same priority class and
+ * no class is limited, which is how the pool ran tasks before the
+ * priority classes. With mode=priority the finds are interactive
+ * and the stores background tasks, limited to half of the workers
+ * like the client does by default.
+ *
+ * Usage: task_pool_bench [workers] [stores] [finds]
+ *
+ * Output is one line per mode and operation, for example:
+ * mode=priority op=find tasks=200 wait_avg_ms=0.1 wait_max_ms=1.2 seconds=1.105
+ */
+#include <ace/OS_NS_sys_time.h>
+#include <ace/OS_NS_unistd.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "dht/kadc/task_pool.h"
+
+using namespace dht;
+using namespace dht::kadc;
+
+class sleep_task : public task {
+    time_value_type _duration;
+    time_value_type _queued_at;
+    time_value_type _waited;
+public:
+    sleep_task(const char *id, const time_value_type &d)
+      : task(id), _duration(d) {}
+
+    void queued() { _queued_at = ACE_OS::gettimeofday(); }
+    const time_value_type &waited() const { return _waited; }
+
+    virtual int svc(void) {
+        _waited = ACE_OS::gettimeofday() - _queued_at;
+        ACE_OS::sleep(_duration);
+        return 0;
+    }
+};
+
+static double
+msec(const time_value_type &t) {
+    return t.sec() * 1000.0 + t.usec() / 1000.0;
+}
+
+static void
+report(const char *mode, const char *op,
+       const std::vector<sleep_task *> &tasks, double seconds)
+{
+    time_value_type total, max;
+    for (size_t i = 0; i < tasks.size(); i++) {
+        total += tasks[i]->waited();
+        if (tasks[i]->waited() > max) max = tasks[i]->waited();
+    }
+    printf("mode=%s op=%s tasks=%lu wait_avg_ms=%.1f wait_max_ms=%.1f "
+           "seconds=%.3f\n",
+           mode, op, (unsigned long)tasks.size(),
+           tasks.empty() ? 0.0 : msec(total) / tasks.size(), msec(max),
+           seconds);
+}
+
+static void
+run(bool prio, size_t workers, size_t stores, size_t finds) {
+    task_pool pool;
+    if (prio) pool.limit(prio_background, std::max<size_t>(workers / 2, 1));
+    pool.start(workers, 0);
+
+    std::vector<sleep_task *> s, f;
+    time_value_type start = ACE_OS::gettimeofday();
+    for (size_t i = 0; i < stores; i++) {
+        sleep_task *t = new sleep_task("store", time_value_type(0, 50000));
+        t->priority(prio ? prio_background : prio_normal);
+        t->queued();
+        pool.submit(t);
+        s.push_back(t);
+    }
+    for (size_t i = 0; i < finds; i++) {
+        sleep_task *t = new sleep_task("find", time_value_type(0, 5000));
+        t->priority(prio ? prio_interactive : prio_normal);
+        t->queued();
+        pool.submit(t);
+        f.push_back(t);
+        ACE_OS::sleep(time_value_type(0, 2000));
+    }
+
+    for (size_t i = 0; i < f.size(); i++) f[i]->join();
+    double finds_done = msec(ACE_OS::gettimeofday() - start) / 1000.0;
+    for (size_t i = 0; i < s.size(); i++) s[i]->join();
+    double stores_done = msec(ACE_OS::gettimeofday() - start) / 1000.0;
+    pool.stop();
+
+    const char *mode = prio ? "priority" : "fifo";
+    report(mode, "find",  f, finds_done);
+    report(mode, "store", s, stores_done);
+
+    for (size_t i = 0; i < s.size(); i++) delete s[i];
+    for (size_t i = 0; i < f.size(); i++) delete f[i];
+}
+
+int
+main(int argc, char *argv[]) {
+    size_t workers = argc > 1 ? strtoul(argv[1], NULL, 10) : 16;
+    size_t stores  = argc > 2 ? strtoul(argv[2], NULL, 10) : 400;
+    size_t finds   = argc > 3 ? strtoul(argv[3], NULL, 10) : 200;
+    if (workers == 0) workers = 1;
+
+    run(false, workers, stores, finds);
+    run(true,  workers, stores, finds);
+    return 0;
+}
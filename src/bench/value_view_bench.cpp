@@ -0,0 +1,156 @@
+/**
+ * File: value_view_bench.cpp
+ * 
+ * Measures the cost per search result of taking a KadC hit to the
+ * search handler, with results delivered as dht::value (find_view=0)
+ * and as dht::value_view (find_view=1) in the KadC client.
+ * 
+ * value: the value hash and each string tag are set to a new 
+ * dht::value, as util::kadc_result does, and found() is called.
+ * view: the hash and the tags are appended to the raw buffer of the
+ * result message, as util::kadc_result_raw does, and found_view()
+ * is called with a view of the record.
+ * 
+ * The handler either reads one tag of each result (op=read_one), 
+ * keeps a copy of each result (op=keep) or drops them (op=drop).
+ * KadC's dictionaries can not be created outside a search, so the
+ * tags come from a table of typical tags.
+ * 
+ * Usage: value_view_bench [hits] [tags]
+ * 
+ * Output is one line per result mode and handler operation, e.g.
+ * mode=view op=read_one hits=1000000 tags=4 seconds=0.100 ns_per_hit=100.0
+ */
+#include <ace/OS_NS_sys_time.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "dht/search_handler.h"
+#include "dht/value_view.h"
+
+struct tag {
+    const char *name;
+    const char *value;
+};
+
+static const tag tags[] = {
+    { "filename", "some_file_name.txt" },
+    { "size",     "1048576" },
+    { "type",     "Doc" },
+    { "format",   "txt" },
+    { "artist",   "an artist with a long name" },
+    { "album",    "album" },
+    { "title",    "title" },
+    { "bitrate",  "128" },
+};
+
+enum handler_op { op_drop, op_read_one, op_keep };
+static const char *op_names[] = { "drop", "read_one", "keep" };
+
+class bench_handler : public dht::search_handler {
+    handler_op              _op;
+    size_t                  _read;
+    std::vector<dht::value> _kept;
+public:
+    bench_handler(handler_op op) : _op(op), _read(0) {}
+    
+    virtual int found(const dht::key &k, const dht::value &v) {
+        if (_op == op_read_one && v.meta().exists("size")) 
+            _read += v.meta().get("size").size();
+        else if (_op == op_keep) 
+            _kept.push_back(v);
+        return 0;
+    }
+    virtual int found_view(const dht::key &k, const dht::value_view &v) {
+        if (_op == op_read_one) {
+            const char *s = v.meta("size");
+            if (s) _read += strlen(s);
+        } else if (_op == op_keep) {
+            _kept.push_back(dht::value());
+            v.copy(&_kept.back());
+        }
+        return 0;
+    }
+    size_t read() const { return _read + _kept.size(); }
+};
+
+static double
+seconds_since(const ACE_Time_Value &start) {
+    ACE_Time_Value d = ACE_OS::gettimeofday() - start;
+    return d.sec() + d.usec() / 1000000.0;
+}
+
+static void
+report(const char *mode, handler_op op, size_t hits, size_t ntags, 
+       double seconds) 
+{
+    printf("mode=%s op=%s hits=%lu tags=%lu seconds=%.3f "
+           "ns_per_hit=%.1f\n",
+           mode, op_names[op], (unsigned long)hits, (unsigned long)ntags,
+           seconds, seconds * 1e9 / hits);
+}
+
+static const unsigned char vhash[16] = { 1, 2, 3, 4, 5, 6, 7, 8, 
+                                         9, 10, 11, 12, 13, 14, 15, 16 };
+
+static size_t
+run_value(handler_op op, size_t hits, size_t ntags) {
+    bench_handler  h(op);
+    dht::key       k("bench://key");
+    ACE_Time_Value start = ACE_OS::gettimeofday();
+    for (size_t i = 0; i < hits; i++) {
+        // The value is part of the result message
+        dht::value v;
+        v.set(vhash, sizeof(vhash));
+        for (size_t t = 0; t < ntags; t++)
+            v.meta().set(tags[t].name, tags[t].value);
+        h.found(k, v);
+    }
+    report("value", op, hits, ntags, seconds_since(start));
+    return h.read();
+}
+
+static size_t
+run_view(handler_op op, size_t hits, size_t ntags) {
+    bench_handler  h(op);
+    dht::key       k("bench://key");
+    ACE_Time_Value start = ACE_OS::gettimeofday();
+    for (size_t i = 0; i < hits; i++) {
+        // The raw buffer is part of the result message
+        std::string raw;
+        raw.append((const char *)vhash, sizeof(vhash));
+        for (size_t t = 0; t < ntags; t++) {
+            raw.append(tags[t].name);
+            raw.push_back('\0');
+            raw.append(tags[t].value);
+            raw.push_back('\0');
+        }
+        dht::value_view v(raw.data(), sizeof(vhash), 
+                          raw.data() + sizeof(vhash), 
+                          raw.size() - sizeof(vhash));
+        h.found_view(k, v);
+    }
+    report("view", op, hits, ntags, seconds_since(start));
+    return h.read();
+}
+
+int
+main(int argc, char *argv[]) {
+    size_t hits  = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+    size_t ntags = argc > 2 ? strtoul(argv[2], NULL, 10) : 4;
+    if (ntags > sizeof(tags) / sizeof(tags[0])) 
+        ntags = sizeof(tags) / sizeof(tags[0]);
+    
+    size_t total = 0;
+    for (int op = op_drop; op <= op_keep; op++) {
+        total += run_value((handler_op)op, hits, ntags);
+        total += run_view ((handler_op)op, hits, ntags);
+    }
+    if (total == 1) printf("\n"); // keep the results
+    return 0;
+}
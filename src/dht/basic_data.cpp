@@ -2,5 +2,13 @@
 
 namespace dht {
     basic_data::~basic_data() {
-    }   
+    }
+    
+    void 
+    basic_data::swap(basic_data &o) {
+        if (this == &o) return;
+        _data.swap(o._data);
+        _changed();
+        o._changed();
+    }
 } // ns dht
@@ -3,9 +3,26 @@
 
 #include <ace/Log_Msg.h>
 #include <stddef.h>
+#include <string.h>
 
 #include <string>
 
+#include "small_string.h"
+
+/**
+ * @brief Largest data kept inside basic_data objects
+ * 
+ * Data up to this size is stored in the object itself, larger data
+ * is allocated from the heap. Can be defined at build time, must
+ * be at least 32.
+ */
+#ifndef DHT_BASIC_DATA_INLINE_SIZE
+#define DHT_BASIC_DATA_INLINE_SIZE 32
+#endif
+#if DHT_BASIC_DATA_INLINE_SIZE < 32
+#error DHT_BASIC_DATA_INLINE_SIZE must be at least 32
+#endif
+
 namespace dht {
     /** 
      * @class basic_data basic_data.h dht/basic_data.h
@@ -14,9 +31,23 @@ namespace dht {
      * This class encapsulates a simple data block which may contain
      * also non-alphanumeric data. Should be used for relatively short
      * amounts of data.
+     * 
+     * Data of at most DHT_BASIC_DATA_INLINE_SIZE bytes is kept inside
+     * the object, so most keys and values are created and copied 
+     * without allocating memory.
      */
     class basic_data {
-        std::string _data;
+    public:
+        const static size_t inline_size = DHT_BASIC_DATA_INLINE_SIZE;
+    private:
+        small_string<inline_size> _data;
+    protected:
+        /**
+         * @brief Called by set functions after the data has changed
+         * 
+         * Not called for the data given to constructors.
+         */
+        virtual void _changed() {}
     public:
         /**
          * @brief constructor
@@ -44,8 +75,10 @@ namespace dht {
          * Copies the string data
          */
         inline basic_data(const char *str);
-
-        // inline basic_data(const basic_data &o);
+        /**
+         * @brief copy constructor
+         */
+        inline basic_data(const basic_data &o);
 
         /**
          * @brief Destructor
@@ -93,29 +126,40 @@ namespace dht {
          */
         inline size_t size() const;             
 
-        // inline basic_data &operator=(const basic_data &o);
-
+        /**
+         * @brief Copies the data of another object
+         */
+        inline basic_data &operator=(const basic_data &o);
+        
+        /**
+         * @brief Exchanges the data with another object
+         * 
+         * Does not copy data that is allocated from the heap, so 
+         * this can be used to move data from an object to another.
+         */
+        void swap(basic_data &o);
     };
 
     inline basic_data::basic_data() {}
-    inline basic_data::basic_data(const void *data, size_t len) { 
-        set((const char *)data, len); }
-    inline basic_data::basic_data(const std::string &str)         { set(str); }
-    inline basic_data::basic_data(const char   *str)         { set(str); }
-/*    inline basic_data::basic_data(const basic_data &o)       { 
-        _data = o._data;
-    }
-*/    
+    inline basic_data::basic_data(const void *data, size_t len) 
+        : _data((const char *)data, len) {}
+    inline basic_data::basic_data(const std::string &str) : _data(str) {}
+    inline basic_data::basic_data(const char   *str)      : _data(str) {}
+    inline basic_data::basic_data(const basic_data &o)    : _data(o._data) {}
+    
     inline void basic_data::set(const void *data, size_t len) {
         _data.assign((const char *)data, len);
+        _changed();
     }
     inline void basic_data::set(const std::string &str) {
         // ACE_DEBUG((LM_DEBUG, "basic_data::set string: %s\n", str.c_str()));
-        _data.assign(str);
+        _data.assign(str.data(), str.size());
+        _changed();
     }
     inline void basic_data::set(const char *str) {
         // ACE_DEBUG((LM_DEBUG, "basic_data::set C string: %s\n", str));
-        _data.assign(str);
+        _data.assign(str, strlen(str));
+        _changed();
     }
     inline const void *basic_data::data() const {
         return (const void *)_data.data();
@@ -127,11 +171,13 @@ namespace dht {
         return _data.size();
     }   
 
-/*
     inline basic_data &basic_data::operator=(const basic_data &o) {     
-        _data = o._data;
+        if (this != &o) {
+            _data = o._data;
+            _changed();
+        }
         return *this;
-    } */
+    }
 
 } // ns dht
 #endif // DHT_BASIC_DATA_H_
@@ -1,4 +1,5 @@
 #include "event_observer_notifier.h"
+#include "exception.h"
 #include "client.h"
 
 namespace dht {
@@ -31,6 +32,30 @@ client::state_str(int state) const {
     return "<unknown>";
 }
 
+void
+client::find_move(key *fkey, search_handler *handler) {
+    find(*fkey, handler);
+}
+
+void
+client::store_move(key *skey, value *svalue, notify_handler *handler) {
+    store(*skey, *svalue, handler);
+}
+
+void
+client::find_many(const key *, const key *, search_handler *) {
+    throw call_error("dht::client::find_many not supported by the "
+                     "implementation");
+}
+
+void
+client::store_many(const key_value *, const key_value *, 
+                   store_many_handler *) 
+{
+    throw call_error("dht::client::store_many not supported by the "
+                     "implementation");
+}
+
 void client::observer_attach(event_observer *h,
                             int event_mask)
 {
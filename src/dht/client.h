@@ -1,12 +1,15 @@
 #ifndef DHT_CLIENT_H_
 #define DHT_CLIENT_H_
 
+#include <utility>
+
 #include "common.h"
 #include "key.h"
 #include "value.h"
 #include "name_value_map.h"
 #include "notify_handler.h"
 #include "search_handler.h"
+#include "store_many_handler.h"
 #include "event_observer_notifier.h"
 
 /**
@@ -89,6 +92,12 @@ namespace dht {
      * make sure all handlers are called only from the thread that
      * called process() function.
      * 
+     * Keys and values given to the functions are const, but an
+     * implementation may cache their digests in them during the call
+     * (see store_data::cache_digest()). The same key or value object
+     * must therefore not be given to or used by other threads while 
+     * a call is using it; copies can be used freely.
+     * 
      * The most convenient way to obtain results is by adding observers for different
      * events, such as change of state (from connecting to connected),
      * search results etc. Several of the functions can also receive pointer 
@@ -235,11 +244,50 @@ namespace dht {
          *                 from the DHT, the handler is allowed to be called
          *                 more than once for the same key/value pair.
          * 
+         * The digest of fkey may be cached in it, so it must not be
+         * used by other threads during the call.
+         * 
          * @see search_handler
          */     
         virtual void find(const dht::key      &fkey,
                           dht::search_handler *handler) = 0;
 
+        /**
+         * @brief Searches the DHT, moving the key into the operation
+         * @param fkey     The key to search. Its contents are taken by
+         *                 swapping and are unspecified after the call.
+         * @param handler  As with find()
+         * 
+         * Same as find(), but lets the implementation keep the key
+         * without copying it. The default implementation calls find().
+         */
+        virtual void find_move(dht::key            *fkey,
+                               dht::search_handler *handler);
+
+        /**
+         * @brief Searches the DHT for values of many keys
+         * @param begin    pointer to the first key to search
+         * @param end      pointer past the last key to search
+         * @param handler  the handler which is notified of the values
+         *                 found for each key, when search of each key is
+         *                 finished and finally when all are finished
+         * 
+         * Implementations search the keys with a limited number of
+         * parallel operations instead of starting a find() for each.
+         * The handler gets the results like with find(), with the 
+         * searched key passed in each call. If found() returns non-zero
+         * no more results of that key are delivered, but searching
+         * the other keys continues. When every key is done 
+         * search_handler::finished() is called.
+         * 
+         * The default implementation throws call_error.
+         * 
+         * @see search_handler
+         */
+        virtual void find_many(const dht::key      *begin,
+                               const dht::key      *end,
+                               dht::search_handler *handler);
+
         /**
          * @brief Stores a value to DHT
          * @param skey     The key that can be used to find the value
@@ -249,12 +297,57 @@ namespace dht {
          *                 to mean the value can be immediately retrieved 
          *                 from the DHT using find().
          * 
+         * The digests of skey and svalue may be cached in them, so 
+         * they must not be used by other threads during the call.
+         * 
          * @see search_handler
          */     
         virtual void store(const dht::key      &skey,
                            const dht::value    &svalue,
                            dht::notify_handler *handler = NULL) = 0;
 
+        /**
+         * @brief Stores a value to DHT, moving the key and the value
+         *        into the operation
+         * @param skey     The key. Its contents are taken by swapping 
+         *                 and are unspecified after the call.
+         * @param svalue   The value, including its meta data. Its 
+         *                 contents are unspecified after the call.
+         * @param handler  As with store()
+         * 
+         * Same as store(), but lets the implementation keep the key 
+         * and the value without copying them. The default 
+         * implementation calls store().
+         */
+        virtual void store_move(dht::key            *skey,
+                                dht::value          *svalue,
+                                dht::notify_handler *handler = NULL);
+
+        /**
+         * @brief A key and the value to store with it
+         */
+        typedef std::pair<dht::key, dht::value> key_value;
+        
+        /**
+         * @brief Stores many values to DHT as one operation
+         * @param begin    pointer to the first key/value pair to store
+         * @param end      pointer past the last key/value pair to store
+         * @param handler  the handler which is notified of the result of
+         *                 each pair and when all of them are done
+         * 
+         * Implementations store the pairs with a limited number of
+         * parallel operations instead of starting a store() for each.
+         * The pairs are copied, so the range does not need to be valid
+         * after the call.
+         * 
+         * The default implementation throws call_error.
+         * 
+         * @see store_many_handler
+         */
+        virtual void store_many(const key_value          *begin,
+                                const key_value          *end,
+                                dht::store_many_handler *handler = NULL);
+
         /**
          * @brief Gets client's external address
          * 
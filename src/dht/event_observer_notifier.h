@@ -28,6 +28,8 @@ namespace dht {
         // So far only state changes, TODO others too
         inline int state_changed(int state);
         inline int search_result(const key &k, const value &v);
+        // True if an observer is attached for the event
+        inline bool observed(int ev_type);
         inline int last_received_state() const;
     };
 
@@ -51,6 +53,11 @@ namespace dht {
         return (o ? o->search_result(k, v) : 0);
     }
 
+    inline bool
+    event_observer_notifier::observed(int ev_type) {
+        return _find_obs(ev_type) != NULL;
+    }
+
     inline int
     event_observer_notifier::last_received_state() const {
         return _last_received_state;
@@ -0,0 +1,152 @@
+#include <ace/Guard_T.h>
+
+#include "admission.h"
+
+namespace dht {
+namespace kadc {
+
+admission::admission()
+  : _max_calls(0), _max_threads(0), _policy(policy_queue),
+    _calls(0), _threads(0), _waiting(0), _rejected(0), _expired(0),
+    _cond(_m)
+{
+}
+
+void
+admission::limits(size_t max_calls, size_t max_threads, policy_type p) {
+    ACE_Guard<ACE_Thread_Mutex> guard(_m);
+    _max_calls   = max_calls;
+    _max_threads = max_threads;
+    _policy      = p;
+    // Waiting calls may fit in the new limits
+    _cond.broadcast();
+}
+
+bool
+admission::_admits(int prio, size_t threads) const {
+    if (!_fits(threads)) return false;
+    // The smallest waiting call of a class fits if any of them does
+    for (int c = 0; c < prio; c++)
+        if (!_waiters[c].empty() && _fits(*_waiters[c].begin())) 
+            return false;
+    return true;
+}
+
+void
+admission::_leave(int prio, waiters_type::iterator w) {
+    _waiters[prio].erase(w);
+    _waiting--;
+    // Calls of lower classes may have waited for this one
+    if (_waiting) _cond.broadcast();
+}
+
+admission::result
+admission::acquire(task *t, size_t *threads, const time_value_type &deadline)
+{
+    ACE_Guard<ACE_Thread_Mutex> guard(_m);
+    if (_max_threads && *threads > _max_threads) *threads = _max_threads;
+
+    int prio = t->priority();
+    if (prio < 0 || prio >= prio_classes) prio = prio_normal;
+
+    if (!_admits(prio, *threads)) {
+        if (_policy == policy_reject) {
+            _rejected++;
+            ACE_DEBUG((LM_DEBUG, "admission: rejected call of %d threads, "
+                       "running %d calls with %d threads\n",
+                       *threads, _calls, _threads));
+            return call_rejected;
+        }
+
+        waiters_type::iterator w = _waiters[prio].insert(*threads);
+        _waiting++;
+        while (!_admits(prio, *threads)) {
+            if (t->quit()) {
+                _leave(prio, w);
+                return call_aborted;
+            }
+            if (deadline == time_value_type::zero) {
+                _cond.wait();
+            } else if (_cond.wait(&deadline) == -1 && 
+                       !_admits(prio, *threads)) 
+            {
+                // Timed out
+                _leave(prio, w);
+                _expired++;
+                return call_expired;
+            }
+        }
+        _leave(prio, w);
+    }
+
+    _calls++;
+    _threads += *threads;
+    return call_admitted;
+}
+
+void
+admission::release(size_t threads) {
+    ACE_Guard<ACE_Thread_Mutex> guard(_m);
+    _calls--;
+    _threads -= threads;
+    // Waiting calls need different numbers of threads, any of them
+    // may fit now
+    if (_waiting) _cond.broadcast();
+}
+
+void
+admission::interrupt() {
+    ACE_Guard<ACE_Thread_Mutex> guard(_m);
+    if (_waiting) _cond.broadcast();
+}
+
+size_t
+admission::max_calls() const {
+    ACE_Guard<ACE_Thread_Mutex> guard(_m);
+    return _max_calls;
+}
+
+size_t
+admission::max_threads() const {
+    ACE_Guard<ACE_Thread_Mutex> guard(_m);
+    return _max_threads;
+}
+
+admission::policy_type
+admission::policy() const {
+    ACE_Guard<ACE_Thread_Mutex> guard(_m);
+    return _policy;
+}
+
+size_t
+admission::calls() const {
+    ACE_Guard<ACE_Thread_Mutex> guard(_m);
+    return _calls;
+}
+
+size_t
+admission::threads() const {
+    ACE_Guard<ACE_Thread_Mutex> guard(_m);
+    return _threads;
+}
+
+size_t
+admission::waiting() const {
+    ACE_Guard<ACE_Thread_Mutex> guard(_m);
+    return _waiting;
+}
+
+unsigned long
+admission::rejected() const {
+    ACE_Guard<ACE_Thread_Mutex> guard(_m);
+    return _rejected;
+}
+
+unsigned long
+admission::expired() const {
+    ACE_Guard<ACE_Thread_Mutex> guard(_m);
+    return _expired;
+}
+
+} // ns kadc
+} // ns dht
@@ -0,0 +1,97 @@
+#ifndef DHT_KADC_ADMISSION_H_
+#define DHT_KADC_ADMISSION_H_
+
+#include <set>
+
+#include <ace/Condition_T.h>
+#include <ace/Thread_Mutex.h>
+
+#include "../common.h"
+#include "task.h"
+
+namespace dht {
+namespace kadc {
+    /**
+     * Limits the number of KadC calls (KadC_find2, KadC_republish)
+     * running at the same time and the number of KadC threads they
+     * use in total. Tasks acquire a call before calling KadC and
+     * release it when the call returns.
+     *
+     * Calls over the limits either wait until running calls have
+     * returned (policy_queue) or are rejected at once
+     * (policy_reject). A call asking for more threads than the
+     * thread limit is given only that many threads.
+     *
+     * Waiting calls are admitted by the priority_class of their task.
+     * A call is admitted only when no waiting call of a higher class
+     * fits in the limits, so that background stores do not take the
+     * threads freed for an interactive find.
+     */
+    class admission {
+    public:
+        enum policy_type { policy_queue, policy_reject };
+        enum result {
+            call_admitted,
+            // Over the limits with policy_reject
+            call_rejected,
+            // The deadline passed while waiting
+            call_expired,
+            // The task was told to quit while waiting
+            call_aborted
+        };
+    private:
+        // Threads asked by the waiting calls of a priority_class
+        typedef std::multiset<size_t> waiters_type;
+
+        size_t      _max_calls;
+        size_t      _max_threads;
+        policy_type _policy;
+
+        size_t        _calls;
+        size_t        _threads;
+        size_t        _waiting;
+        unsigned long _rejected;
+        unsigned long _expired;
+        waiters_type  _waiters[prio_classes];
+
+        mutable ACE_Thread_Mutex        _m;
+        ACE_Condition<ACE_Thread_Mutex> _cond;
+
+        inline bool _fits(size_t threads) const {
+            return (!_max_calls   || _calls + 1 <= _max_calls) &&
+                   (!_max_threads || _threads + threads <= _max_threads);
+        }
+        bool _admits(int prio, size_t threads) const;
+        void _leave(int prio, waiters_type::iterator w);
+    public:
+        admission();
+
+        // 0 for no limit
+        void limits(size_t max_calls, size_t max_threads, policy_type p);
+
+        // Acquires a call using *threads KadC threads, lowering
+        // *threads to the thread limit if needed. With policy_queue
+        // waits until the call fits in the limits, until the deadline
+        // if it is not zero. The call waits in the priority() of t.
+        result acquire(task *t, size_t *threads,
+                       const time_value_type &deadline);
+        void   release(size_t threads);
+        // Wakes the waiting tasks to check whether they should quit
+        void   interrupt();
+
+        size_t        max_calls()   const;
+        size_t        max_threads() const;
+        policy_type   policy()      const;
+        // Calls running now and the KadC threads they use
+        size_t        calls()       const;
+        size_t        threads()     const;
+        // Calls waiting for their turn
+        size_t        waiting()     const;
+        unsigned long rejected()    const;
+        unsigned long expired()     const;
+    };
+
+} // ns kadc
+} // ns dht
+
+#endif //DHT_KADC_ADMISSION_H_
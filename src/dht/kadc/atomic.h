@@ -0,0 +1,54 @@
+#ifndef DHT_KADC_ATOMIC_H_
+#define DHT_KADC_ATOMIC_H_
+
+/**
+ * Minimal atomic operations needed by the lock-free structures
+ * of kadc implementation. Implemented with GCC's __sync builtins,
+ * which are available both with Linux and MinGW toolchains.
+ */
+namespace dht {
+namespace kadc {
+namespace atomic {
+
+    // Full memory barrier
+    inline void fence() { __sync_synchronize(); }
+
+    // Load with acquire semantics
+    template <class T>
+    inline T load(const volatile T *p) {
+        T v = *p;
+        __sync_synchronize();
+        return v;
+    }
+    
+    // Store with release semantics
+    template <class T>
+    inline void store(volatile T *p, T v) {
+        __sync_synchronize();
+        *p = v;
+    }
+    
+    // Stores v to *p and returns the previous value. Full barrier.
+    template <class T>
+    inline T exchange(volatile T *p, T v) {
+        __sync_synchronize();
+        return __sync_lock_test_and_set(p, v);
+    }
+    
+    // Sets *p to v if it equals to expected. Returns true if set.
+    template <class T>
+    inline bool compare_and_swap(volatile T *p, T expected, T v) {
+        return __sync_bool_compare_and_swap(p, expected, v);
+    }
+
+    // Adds v to *p and returns the new value.
+    template <class T>
+    inline T add(volatile T *p, T v) {
+        return __sync_add_and_fetch(p, v);
+    }
+    
+} // ns atomic
+} // ns kadc
+} // ns dht
+
+#endif //DHT_KADC_ATOMIC_H_
@@ -1,4 +1,7 @@
 #include <ace/Guard_T.h>
+#include <ace/OS_NS_sys_time.h>
+
+#include <stdlib.h>
 
 #include <list>
 #include <algorithm>
@@ -6,7 +9,13 @@
 #include "../notify_handler.h"
 #include "client.h"
 #include "observer_message.h"
+#include "message_search_batch.h"
+#include "message_search_view.h"
+#include "message_search_many.h"
 #include "task_connected_detect.h"
+#include "task_find.h"
+#include "task_find_many.h"
+#include "task_parts.h"
 #include "state_disconnected.h"
 #include "reactor_event_handler.h"
 
@@ -15,6 +24,12 @@ using namespace std;
 namespace dht {
 namespace kadc {
 
+static size_t 
+opt_size(const name_value_map &opts, const char *name, size_t def) {
+    if (!opts.exists(name)) return def;
+    return (size_t)strtoul(opts.get(name).c_str(), NULL, 10);
+}
+
 client::client()    {
     _state     = state_disconnected::instance();
     _state_out = disconnected;
@@ -24,18 +39,55 @@ client::client()    {
     // Use KadC defaults
     _find_threads = _find_duration = 0;
     _find_max_hits = 500;
+    _find_batch_size   = 1;
+    _find_batch_window = time_value_type(0, 50 * 1000);
     _store_threads = _store_duration = 0;
+    _store_many_threads = 4;
+    _find_many_threads  = 4;
+    
+    _snapshot_interval = time_value_type::zero;
+    
+    _connect_nodes    = 20;
+    _connect_timeout  = time_value_type(120);
+    _node_timeout     = time_value_type(30);
+    _connect_poll_min = time_value_type(0, 50 * 1000);
+    _connect_poll_max = time_value_type(0, 500 * 1000);
+    
+    _pool_workers    = 16;
+    _pool_max_queued = 1024;
+    _pool            = NULL;
+    _pool_limits[prio_interactive] = 0;
+    _pool_limits[prio_normal]      = 0;
+    _pool_limits[prio_background]  = _pool_workers / 2;
+    
+    _cache_max_entries = 0;
+    _cache_max_bytes   = 0;
+    _cache_ttl         = time_value_type(300);
+    _cache             = NULL;
+    _find_dedup        = false;
+    _find_dedup_hits   = 0;
+    _find_view         = false;
     
     // Unless otherwise instructed, use ACE's system wide reactor
     _reactor   = reactor_type::instance();
     _rehandler = new reactor_event_handler(this);
     _msg_queue.target(_rehandler);
+    _batch_timer = -1;
 }
 
 client::~client()   {
     ACE_DEBUG((LM_DEBUG, "dht::kadc::client: dtor called\n"));
-    // Must wait/kill every thread that is spawned.
+    // Must wait/kill every thread that is spawned. Tasks still
+    // queued in the pool will exit as soon as they are started.
+    _quit_all_tasks();
     _wait_running_tasks();
+    if (_pool) {
+        ACE_DEBUG((LM_DEBUG, "dht::kadc::client: dtor stopping task pool\n"));
+        _pool->stop();
+        delete _pool;
+    }
+    delete _cache;
+    _batch_timer_cancel();
     ACE_DEBUG((LM_DEBUG, "dht::kadc::client: dtor deleting reactor event handler\n"));
     delete _rehandler;
 }
@@ -44,6 +96,103 @@ void
 client::init(const name_value_map &opts) {
     ACE_DEBUG((LM_DEBUG, "kadc::init called\n"));
     _init_file = opts.get("init_file");
+    _snapshot_file = opts.get("snapshot_file", _init_file + ".snapshot");
+    if (opts.exists("snapshot_interval")) {
+        _snapshot_interval.sec((long)opt_size(opts, "snapshot_interval", 0));
+        _snapshot_interval.usec(0);
+    }
+    
+    // Zero nodes would report connected before any node is contacted
+    _connect_nodes = std::max<size_t>(opt_size(opts, "connect_nodes", 
+                                               _connect_nodes), 1);
+    if (opts.exists("connect_timeout")) {
+        _connect_timeout.sec((long)opt_size(opts, "connect_timeout", 0));
+        _connect_timeout.usec(0);
+    }
+    if (opts.exists("node_timeout")) {
+        _node_timeout.sec((long)opt_size(opts, "node_timeout", 0));
+        _node_timeout.usec(0);
+    }
+    // A zero interval would never grow and the detect thread would
+    // spin, so polling is at most once a millisecond
+    if (opts.exists("connect_poll_min")) {
+        _connect_poll_min.msec((long)std::max<size_t>(
+          opt_size(opts, "connect_poll_min", 0), 1));
+    }
+    if (opts.exists("connect_poll_max")) {
+        _connect_poll_max.msec((long)opt_size(opts, "connect_poll_max", 0));
+    }
+    if (_connect_poll_max < _connect_poll_min) 
+        _connect_poll_max = _connect_poll_min;
+    
+    _pool_workers    = opt_size(opts, "task_pool_size",  _pool_workers);
+    _pool_max_queued = opt_size(opts, "task_queue_size", _pool_max_queued);
+    if (opts.exists("task_pool_size"))
+        _pool_limits[prio_background] = std::max<size_t>(_pool_workers / 2, 1);
+    _pool_limits[prio_interactive] = opt_size(opts, 
+                                              "task_pool_limit_interactive",
+                                              _pool_limits[prio_interactive]);
+    _pool_limits[prio_normal]      = opt_size(opts, "task_pool_limit_normal",
+                                              _pool_limits[prio_normal]);
+    _pool_limits[prio_background]  = opt_size(opts, 
+                                              "task_pool_limit_background",
+                                              _pool_limits[prio_background]);
+    
+    _find_batch_size = opt_size(opts, "find_batch_size", _find_batch_size);
+    if (opts.exists("find_batch_window")) {
+        _find_batch_window.msec((long)opt_size(opts, "find_batch_window", 0));
+    }
+    
+    _cache_max_entries = opt_size(opts, "find_cache_size",   
+                                  _cache_max_entries);
+    _cache_max_bytes   = opt_size(opts, "find_cache_memory", 
+                                  _cache_max_bytes);
+    if (opts.exists("find_cache_ttl")) {
+        _cache_ttl.sec((long)opt_size(opts, "find_cache_ttl", 0));
+    }
+    if (opts.exists("store_many_threads")) {
+        store_many_threads(opt_size(opts, "store_many_threads", 0));
+    }
+    if (opts.exists("find_many_threads")) {
+        find_many_threads(opt_size(opts, "find_many_threads", 0));
+    }
+    if (opts.exists("kadc_max_calls") || opts.exists("kadc_max_threads") ||
+        opts.exists("kadc_admission"))
+    {
+        string p = opts.get("kadc_admission", "queue");
+        admission::policy_type policy;
+        if (p == "queue")
+            policy = admission::policy_queue;
+        else if (p == "reject")
+            policy = admission::policy_reject;
+        else
+            throw call_errorf("dht::kadc::init unknown kadc_admission '%s'", 
+                              p.c_str());
+        
+        _admission.limits(
+            opt_size(opts, "kadc_max_calls",   _admission.max_calls()),
+            opt_size(opts, "kadc_max_threads", _admission.max_threads()),
+            policy);
+    }
+    _find_dedup = opt_size(opts, "find_dedup", _find_dedup) != 0;
+    _find_view  = opt_size(opts, "find_view",  _find_view)  != 0;
+    
+    if (_cache == NULL && (_cache_max_entries > 0 || _cache_max_bytes > 0)) {
+        _cache = new result_cache(_cache_max_entries, _cache_max_bytes, 
+                                  _cache_ttl);
+    }
+    
+    if (_pool == NULL && _pool_workers > 0) {
+        _pool = new task_pool;
+        for (int c = 0; c < prio_classes; c++) 
+            _pool->limit(c, _pool_limits[c]);
+        if (_pool->start(_pool_workers, _pool_max_queued) == -1) {
+            delete _pool;
+            _pool = NULL;
+            throw operation_errorf("Could not start %d task pool workers", 
+                                   _pool_workers);
+        }
+    }
 }
 
 void
@@ -82,6 +231,116 @@ client::contacts() const {
     return KadC_getncontacts(&_kcc);   
 }
 
+size_t
+client::task_pool_size() const {
+    return _pool ? _pool->workers() : 0;
+}
+
+size_t
+client::task_pool_busy() const {
+    return _pool ? _pool->busy() : 0;
+}
+
+size_t
+client::task_pool_peak_busy() const {
+    return _pool ? _pool->peak_busy() : 0;
+}
+
+size_t
+client::task_pool_queued() const {
+    return _pool ? _pool->queued() : 0;
+}
+
+size_t
+client::task_pool_queued(int prio) const {
+    return _pool ? _pool->queued(prio) : 0;
+}
+
+size_t
+client::task_pool_limit(int prio) const {
+    return _pool ? _pool->limit(prio) : 0;
+}
+
+queue_wait_stats
+client::task_pool_queue_wait(int prio) const {
+    return _pool ? _pool->queue_wait(prio) : queue_wait_stats();
+}
+
+void
+client::task_pool_queue_wait_reset() {
+    if (_pool) _pool->queue_wait_reset();
+}
+
+size_t
+client::kadc_calls() const {
+    return _admission.calls();
+}
+
+size_t
+client::kadc_threads() const {
+    return _admission.threads();
+}
+
+size_t
+client::kadc_calls_waiting() const {
+    return _admission.waiting();
+}
+
+unsigned long
+client::kadc_calls_rejected() const {
+    return _admission.rejected();
+}
+
+unsigned long
+client::kadc_calls_expired() const {
+    return _admission.expired();
+}
+
+unsigned long
+client::reactor_wakeups() const {
+    return _rehandler->wakeups();
+}
+
+unsigned long
+client::reactor_wakeups_saved() const {
+    return _rehandler->wakeups_saved();
+}
+
+unsigned long
+client::message_heap_allocations() {
+    return message::pool().heap_allocations();
+}
+
+unsigned long
+client::message_heap_frees() {
+    return message::pool().heap_frees();
+}
+
+unsigned long
+client::find_cache_hits() const {
+    return _cache ? _cache->hits() : 0;
+}
+
+unsigned long
+client::find_cache_misses() const {
+    return _cache ? _cache->misses() : 0;
+}
+
+unsigned long
+client::find_cache_evictions() const {
+    return _cache ? _cache->evictions() : 0;
+}
+
+size_t
+client::find_cache_entries() const {
+    return _cache ? _cache->entries() : 0;
+}
+
+void
+client::find_cache_clear() {
+    if (_cache) _cache->clear();
+}
+
 int
 client::write_inifile(const char *target_file) {
     return KadC_write_inifile(&_kcc, target_file);    
@@ -116,17 +375,99 @@ void
 client::store(const key   &index,
               const value &content,
               notify_handler *notify)
+{
+    store(index, content, notify, store_params());
+}
+
+void
+client::store(const key          &index,
+              const value        &content,
+              notify_handler     *notify,
+              const store_params &params)
 {
     ACE_DEBUG((LM_DEBUG, "kadc::store called\n"));
-    _state->store(this, index, content, notify);
+    // The task gets the parameters as they are now
+    store_params p(params);
+    store_defaults(&p);
+    _state->store(this, index, content, notify, p);
+}
+
+void
+client::store_many(const key_value    *begin,
+                   const key_value    *end,
+                   store_many_handler *notify)
+{
+    ACE_DEBUG((LM_DEBUG, "kadc::store_many called\n"));
+    _state->store_many(this, begin, end, notify);
 }
 
 void
 client::find(const key      &index,
            search_handler *handler)
+{
+    find(index, handler, find_params());
+}
+
+void
+client::find(const key         &index,
+             search_handler    *handler,
+             const find_params &params)
 {
     ACE_DEBUG((LM_DEBUG, "kadc::find called\n"));
-    _state->find(this, index, handler); 
+    // The task gets the parameters as they are now
+    find_params p(params);
+    find_defaults(&p);
+    _state->find(this, index, handler, p); 
+}
+
+void
+client::find_move(key            *index,
+                  search_handler *handler)
+{
+    find_move(index, handler, find_params());
+}
+
+void
+client::find_move(key               *index,
+                  search_handler    *handler,
+                  const find_params &params)
+{
+    ACE_DEBUG((LM_DEBUG, "kadc::find_move called\n"));
+    find_params p(params);
+    find_defaults(&p);
+    _state->find_move(this, index, handler, p); 
+}
+
+void
+client::find_defaults(find_params *p) const {
+    if (p->priority < 0 || p->priority >= prio_classes) 
+        p->priority = prio_interactive;
+    // Limited like the client's own values. max_hits is not, the 
+    // default of 500 hits is already over any such limit.
+    p->threads  = p->threads  ? std::min<size_t>(p->threads, 20) 
+                              : _find_threads;
+    p->duration = p->duration ? std::min<size_t>(p->duration, 200) 
+                              : _find_duration;
+    p->max_hits = p->max_hits ? p->max_hits : _find_max_hits;
+}
+
+void
+client::store_defaults(store_params *p) const {
+    if (p->priority < 0 || p->priority >= prio_classes) 
+        p->priority = prio_background;
+    p->threads  = p->threads  ? std::min<size_t>(p->threads, 20) 
+                              : _store_threads;
+    p->duration = p->duration ? std::min<size_t>(p->duration, 200) 
+                              : _store_duration;
+}
+
+void
+client::find_many(const key      *begin,
+                  const key      *end,
+                  search_handler *handler)
+{
+    ACE_DEBUG((LM_DEBUG, "kadc::find_many called\n"));
+    _state->find_many(this, begin, end, handler); 
 }
 
 const addr_inet_type &
@@ -144,6 +485,8 @@ client::reactor(reactor_type *r) {
     if (r == NULL) {
         throw call_error("dht::kadc::reactor NULL pointer not allowed");
     }
+    // Started again on the new reactor by the next search
+    _batch_timer_cancel();
     _reactor = r;
 }
 
@@ -159,10 +502,40 @@ client::process(time_value_type &max_wait) {
 
 int 
 client::handler_cancel(notify_handler *handler) {
-    // Must go through the observer list and if the handler matches,
-    // set it to NULL so that it won't be called.
+    // Set the handler to NULL in the observers that have it
+    // so that it won't be called.
     ACE_DEBUG((LM_DEBUG, "dht::kadc: handler_cancel\n"));
     int counter = 0;
+    std::list<task *> searches;
+    
+    // Observers of specific tasks are found through the handler index
+    pair<handler_index_type::iterator, handler_index_type::iterator> range =
+        _handler_index.equal_range(handler);
+    for (handler_index_type::iterator hi = range.first; 
+         hi != range.second; hi++)
+    {
+        task_obsvs_type::iterator ti = _task_observers.find(hi->second);
+        if (ti == _task_observers.end()) continue;
+        searches.push_back(hi->second);
+        
+        message_obsvs_type::iterator obs_i = ti->second.begin();
+        for (; obs_i != ti->second.end(); obs_i++) {
+            if (obs_i->handler() == handler) {
+                ACE_DEBUG((LM_DEBUG, "dht::kadc: removing handler ptr %d\n",
+                          obs_i->handler()));
+                obs_i->handler(NULL);
+                counter++;
+            }
+        }
+    }
+    _handler_index.erase(range.first, range.second);
+
+    // Searches whose results nobody gets anymore are ended
+    std::list<task *>::iterator si = searches.begin();
+    for (; si != searches.end(); si++)
+        if (!_search_observed(*si)) _quit_search(*si);
+
+    // Observers not bound to a task are few (connect and disconnect)
     message_obsvs_type::iterator obs_i = _msg_observers.begin();
     for (; obs_i != _msg_observers.end(); obs_i++) {
         if (obs_i->handler() == handler) {
@@ -181,21 +554,73 @@ client::handler_cancel(notify_handler *handler) {
 
 void
 client::_process_queue() {
-    list<message *> rec_msgs;
-    list<message *>::iterator i;
-    
-    ACE_Guard<message_queue_type> guard(_msg_queue); // .acquire();
-    while (_msg_queue.size() > 0) {
-        ACE_DEBUG((LM_DEBUG, "%t kadc::process_queue purging msg queue (size %d)\n",
-                  _msg_queue.size()));
-        rec_msgs.push_back(_msg_queue.front());
-        _msg_queue.pop();
+    // Producers never wait for this thread, so messages pushed while
+    // processing are handled in the same go.
+    message *m;
+    while ((m = _msg_queue.pop()) != NULL)
+        _process_msg(m);
+}
+
+void
+client::_task_submit_parts(task_parts *t) {
+    for (size_t i = 0; i < t->parts(); i++) {
+        task *p = t->part_at(i);
+        p->priority(t->priority());
+        bool started = (_pool ? _pool->submit(p) : p->activate() == 0);
+        if (started) continue;
+        // Nothing runs the owner before its first part has started
+        if (i == 0 && _pool) {
+            throw operation_errorf("dht::kadc task queue full (%d " \
+                                   "operations waiting), try again later",
+                                   _pool->queued());
+        }
+        if (i == 0) {
+            throw operation_error("dht::kadc could not spawn a thread " \
+                                  "for the operation");
+        }
+        // The parts already started do the work of this one
+        t->part_skipped();
     }
+    _running_tasks[t] = t;
+    ACE_DEBUG((LM_DEBUG, "kadc::task_submit_parts %d parts, running " \
+              "tasks size %d\n", t->parts(), _running_tasks.size()));
+}
 
-    guard.release(); // _msg_queue.release();
+void
+client::_batch_timer_start() {
+    if (_batch_timer != -1 || _find_batch_size <= 1) return;
     
-    for (i = rec_msgs.begin(); i != rec_msgs.end(); i++)
-        _process_msg(*i);
+    _batch_timer = this->reactor()->schedule_timer(_rehandler, NULL,
+                                                   _find_batch_window,
+                                                   _find_batch_window);
+    if (_batch_timer == -1)
+        ACE_ERROR((LM_ERROR, "kadc::batch_timer_start schedule failed, " \
+                  "batches are delivered only as results arrive\n"));
+}
+
+void
+client::_batch_timer_cancel() {
+    if (_batch_timer == -1) return;
+    this->reactor()->cancel_timer(_batch_timer);
+    _batch_timer = -1;
+}
+
+void
+client::_flush_batches() {
+    time_value_type now = ACE_OS::gettimeofday();
+    bool searching = false;
+    bool flushed   = false;
+    
+    running_tasks_type::iterator i = _running_tasks.begin();
+    for (; i != _running_tasks.end(); i++) {
+        task_find *tf = dynamic_cast<task_find *>(i->first);
+        if (tf == NULL) continue;
+        searching = true;
+        if (tf->flush_expired(now)) flushed = true;
+    }
+    // Started again by the next search
+    if (!searching) _batch_timer_cancel();
+    if (flushed)    _process_queue();
 }
 
 void
@@ -205,8 +630,17 @@ client::_process_msg(message *tm) {
     case msg_connect:
     case msg_disconnect:
     case msg_store:
+    case msg_store_item:
+    case msg_search_many_result:
+    case msg_search_key_done:
+    case msg_search_many_done:
     case msg_search_result:
+    case msg_search_batch:
+    case msg_search_view:
+        break;
     case msg_search_done:
+        // Finds of the key started from now on need a new search
+        _running_find_done(tm->from_task());
         break;
     case msg_task_exit:
     {
@@ -215,6 +649,8 @@ client::_process_msg(message *tm) {
                    t->id()));
 
         _running_tasks.erase(t);
+        _unobserved.erase(_unobserved.lower_bound(make_pair(t, (size_t)0)),
+                          _unobserved.upper_bound(make_pair(t, (size_t)-1)));
         ACE_DEBUG((LM_DEBUG, "kadc::process remaining running tasks %d\n",
                   _running_tasks.size()));
         ACE_DEBUG((LM_DEBUG, "kadc::process waiting for task to exit\n"));
@@ -227,32 +663,134 @@ client::_process_msg(message *tm) {
         ACE_ERROR((LM_ERROR, "Unrecognized message %d\n", tm->type()));
     }
 
-    // Let each observer process the message
-    message_obsvs_type::iterator obs_i = _msg_observers.begin();
-    list<message_obsvs_type::iterator> rm_observers;
-    for (; obs_i != _msg_observers.end(); obs_i++) {
-        if (!obs_i->from_task() || obs_i->from_task() == tm->from_task()) {
-            ACE_DEBUG((LM_DEBUG, "kadc::process_msg letting observer process " \
-                  "message\n"));        
-            if (obs_i->observer()->received_message(this, tm, *obs_i)) {
-                // ACE_DEBUG((LM_DEBUG, "kadc::process_msg observer to remove list\n"));            
-                rm_observers.push_back(obs_i);
-            }
+    // Let each observer process the message: first the ones interested 
+    // in all messages, then the ones of the task that sent the message
+    _dispatch_msg(tm, &_msg_observers);
+    _notify_search_result(tm);
+    
+    task *t = tm->from_task();
+    task_obsvs_type::iterator ti = (t ? _task_observers.find(t) 
+                                      : _task_observers.end());
+    if (ti != _task_observers.end()) {
+        _dispatch_msg(tm, &ti->second);
+        
+        // A search whose last observer stopped receiving results is 
+        // ended, KadC stops it at its next result. Event observers may
+        // still want its results.
+        if (ti->second.empty() && (tm->type() == msg_search_result ||
+                                   tm->type() == msg_search_batch  ||
+                                   tm->type() == msg_search_view) &&
+            !_search_observed(t))
+            _quit_search(t);
+        
+        // Once the task is gone its remaining observers would never 
+        // get any messages
+        if (ti->second.empty() || tm->type() == msg_task_exit) {
+            message_obsvs_type::iterator obs_i = ti->second.begin();
+            for (; obs_i != ti->second.end(); obs_i++)
+                _unindex_handler(obs_i->handler(), t);
+            _task_observers.erase(ti);
         }
     }
 
-    list<message_obsvs_type::iterator>::iterator rm_i = rm_observers.begin();
-    for (; rm_i != rm_observers.end(); rm_i++) {
-        _msg_observers.erase(*rm_i);
-        ACE_DEBUG((LM_DEBUG, "kadc::process removed observer, size %d\n",
-                  _msg_observers.size()));
-    }
-
     ACE_DEBUG((LM_DEBUG, "kadc::process deleting task ptr %d\n", tm));
     delete tm;
     ACE_DEBUG((LM_DEBUG, "kadc::process deleted\n"));
 }
 
+void
+client::_dispatch_msg(message *tm, message_obsvs_type *obsvs) {
+    message_obsvs_type::iterator obs_i = obsvs->begin();
+    while (obs_i != obsvs->end()) {
+        ACE_DEBUG((LM_DEBUG, "kadc::process_msg letting observer process " \
+                  "message\n"));        
+        if (obs_i->observer()->received_message(this, tm, *obs_i)) {
+            _unindex_handler(obs_i->handler(), obs_i->from_task());
+            obs_i = obsvs->erase(obs_i);
+            ACE_DEBUG((LM_DEBUG, "kadc::process removed observer, " \
+                      "remaining for the task %d\n", obsvs->size()));
+        } else {
+            obs_i++;
+        }
+    }
+}
+
+void
+client::_notify_search_result(message *tm) {
+    const message_search *ms = dynamic_cast<const message_search *>(tm);
+    if (ms == NULL || tm->type() == msg_search_done ||
+        tm->type() == msg_search_key_done)
+        return;
+    if (!this->observer_notifier()->observed(
+            event_observer::mask_search_result))
+        return;
+
+    const message_search_many *mm = 
+        dynamic_cast<const message_search_many *>(tm);
+    pair<task *, size_t> search(tm->from_task(), mm ? mm->item() : 0);
+    if (_unobserved.find(search) != _unobserved.end()) return;
+    
+    const key &k = *(ms->search_key());
+    int ret = 0;
+    switch (tm->type()) {
+    case msg_search_result:
+    case msg_search_many_result:
+        ret = this->observer_notifier()->search_result(k, 
+                                                       *(ms->result_value()));
+        break;
+    case msg_search_batch:
+    {
+        // Observers do not have a batch interface, so they are notified
+        // of each result like when results are not batched.
+        const message_search_batch::values_type &vs = 
+            dynamic_cast<const message_search_batch *>(tm)->result_values();
+        for (size_t i = 0; i < vs.size() && !ret; i++)
+            ret = this->observer_notifier()->search_result(k, vs[i]);
+    }
+        break;
+    case msg_search_view:
+    {
+        // Observers get values, so the viewed records are copied
+        const message_search_view *mv = 
+            dynamic_cast<const message_search_view *>(tm);
+        for (size_t i = 0; i < mv->records() && !ret; i++) {
+            value copy;
+            mv->record(i).copy(&copy);
+            ret = this->observer_notifier()->search_result(k, copy);
+        }
+    }
+        break;
+    }
+    if (!ret) return;
+    _unobserved.insert(search);
+    
+    // A search without handlers is ended as soon as the observers 
+    // do not want its results, a key of find_many() like its handler
+    // stops it
+    task_find_many *tfm = dynamic_cast<task_find_many *>(search.first);
+    if (tfm && mm) {
+        if (!_search_handled(tfm)) tfm->stop(mm->item());
+    } else if (!_search_observed(search.first)) {
+        _quit_search(search.first);
+    }
+}
+
+void
+client::_unindex_handler(notify_handler *h, task *t) {
+    if (h == NULL || t == NULL) return;
+    
+    pair<handler_index_type::iterator, handler_index_type::iterator> range =
+        _handler_index.equal_range(h);
+    for (handler_index_type::iterator hi = range.first; 
+         hi != range.second; hi++)
+    {
+        if (hi->second == t) {
+            _handler_index.erase(hi);
+            return;
+        }
+    }
+}
+
 void 
 client::_change_state(state *s) { 
     ACE_DEBUG((LM_DEBUG, "kadc::change_state new state %s\n", s->id()));
@@ -273,6 +811,95 @@ client::_task_add(task *t) {
     t->activate();
 }
 
+void
+client::_task_submit(task *t) {
+    task_parts *tp = dynamic_cast<task_parts *>(t);
+    if (tp) {
+        _task_submit_parts(tp);
+        return;
+    }
+    if (_pool == NULL) {
+        _task_add(t);
+        if (dynamic_cast<task_find *>(t)) _batch_timer_start();
+        return;
+    }
+    if (!_pool->submit(t)) {
+        throw operation_errorf("dht::kadc task queue full (%d operations " \
+                               "waiting), try again later", 
+                               _pool->queued());
+    }
+    _running_tasks[t] = t;
+    if (dynamic_cast<task_find *>(t)) _batch_timer_start();
+    ACE_DEBUG((LM_DEBUG, "kadc::task_submit running tasks size %d, " \
+              "pool busy/queued %d/%d\n",
+              _running_tasks.size(), _pool->busy(), _pool->queued()));
+}
+
+void
+client::_task_run(task *t) {
+    // Marked pooled, so that task::join() does not wait for a thread
+    t->pooled(true);
+    _running_tasks[t] = t;
+    t->run();
+}
+
+task *
+client::_running_find(const key128 &index) {
+    if (!_find_dedup) return NULL;
+    running_finds_type::iterator i = _running_finds.find(index);
+    if (i == _running_finds.end()) return NULL;
+    _find_dedup_hits++;
+    return i->second;
+}
+
+void
+client::_running_find_add(const key128 &index, task *t) {
+    if (_find_dedup) _running_finds[index] = t;
+}
+
+void
+client::_running_find_done(task *t) {
+    task_find *tf = dynamic_cast<task_find *>(t);
+    if (tf == NULL) return;
+    running_finds_type::iterator i = _running_finds.find(tf->index());
+    if (i != _running_finds.end() && i->second == t)
+        _running_finds.erase(i);
+}
+
+void
+client::_quit_search(task *t) {
+    if (dynamic_cast<task_find *>(t)      == NULL &&
+        dynamic_cast<task_find_many *>(t) == NULL) return;
+    
+    // Finds of the key started from now on need a new search
+    _running_find_done(t);
+    _quit_task(t);
+}
+
+bool
+client::_search_observed(task *t) {
+    // Event observers get the results of all searches, until they
+    // return non-zero for the search. Some keys of find_many() may
+    // still be observed, so it is not ended for them.
+    if (this->observer_notifier()->observed(
+            event_observer::mask_search_result) &&
+        (dynamic_cast<task_find_many *>(t) ||
+         _unobserved.find(make_pair(t, (size_t)0)) == _unobserved.end()))
+        return true;
+    return _search_handled(t);
+}
+
+bool
+client::_search_handled(task *t) {
+    task_obsvs_type::iterator ti = _task_observers.find(t);
+    if (ti == _task_observers.end()) return false;
+    
+    message_obsvs_type::iterator obs_i = ti->second.begin();
+    for (; obs_i != ti->second.end(); obs_i++)
+        if (obs_i->handler()) return true;
+    return false;
+}
+
 void
 client::_quit_all_tasks() {
     running_tasks_type::iterator i = _running_tasks.begin();
@@ -289,14 +916,27 @@ client::_quit_task(task *t) {
     t->acquire();
     t->quit(true);
     t->release();
+    // The task may be waiting for admission of its KadC call
+    _admission.interrupt();
 }
 
 void
 client::_attach_observer_messages(const observer_info &oi) {
-    _msg_observers.push_back(oi);
+    task *t = oi.from_task();
+    if (t == NULL) {
+        _msg_observers.push_back(oi);
+        ACE_DEBUG((LM_DEBUG, "kadc::attach_observer_messages number of " \
+                  "observers %d\n",
+                  _msg_observers.size()));
+        return;
+    }
+    
+    _task_observers[t].push_back(oi);
+    if (oi.handler()) 
+        _handler_index.insert(handler_index_type::value_type(oi.handler(), t));
     ACE_DEBUG((LM_DEBUG, "kadc::attach_observer_messages number of " \
-              "observers %d\n",
-              _msg_observers.size()));
+              "tasks observed %d\n",
+              _task_observers.size()));
 }
 
 bool
@@ -311,10 +951,24 @@ client::_detach_observer_messages(observer_info *oi) {
         *oi   = *i;
         _msg_observers.erase(i);
         return true;
-    } else {
-        ACE_DEBUG((LM_DEBUG, 
-          "kadc::detach_observer_messages observer not found"));
+    } 
+    
+    // Not expected to be used for task observers, so full scan is ok
+    task_obsvs_type::iterator ti = _task_observers.begin();
+    for (; ti != _task_observers.end(); ti++) {
+        for (i = ti->second.begin(); i != ti->second.end(); i++) {
+            if (i->observer() != oi->observer()) continue;
+            
+            *oi = *i;
+            _unindex_handler(i->handler(), ti->first);
+            ti->second.erase(i);
+            if (ti->second.empty()) _task_observers.erase(ti);
+            return true;
+        }
     }
+    
+    ACE_DEBUG((LM_DEBUG, 
+      "kadc::detach_observer_messages observer not found"));
 
     return false;
 }
@@ -6,11 +6,17 @@
 #include <string>
 #include <list>
 #include <map>
+#include <set>
 
 #include "../client.h"
-#include "shared_queue.h"
+#include "mpsc_queue.h"
 #include "message.h"
 #include "observer_info.h"
+#include "task_pool.h"
+#include "result_cache.h"
+#include "key128.h"
+#include "params.h"
+#include "admission.h"
 
 // TODO these should really be in .cpp so that as little as possible
 // of kadc files get included in apps that use dht abstraction
@@ -64,7 +70,7 @@ namespace kadc {
     class client : public dht::client {
     public:
         /// @cond KADC_INTERNAL
-        typedef shared_queue<message *> message_queue_type;
+        typedef mpsc_queue<message> message_queue_type;
         friend class state;
         friend class reactor_event_handler;     
         /// @endcond
@@ -74,6 +80,8 @@ namespace kadc {
         mutable KadCcontext    _kcc;
         bool           _kstarted;
         string         _init_file;
+        string          _snapshot_file;
+        time_value_type _snapshot_interval;
         addr_inet_type _ext_addr;
         reactor_type  *_reactor;
 
@@ -82,15 +90,56 @@ namespace kadc {
                _store_threads,
                _store_duration;
         size_t _find_max_hits;
+        size_t _store_many_threads;
+        size_t _find_many_threads;
+        size_t          _find_batch_size;
+        time_value_type _find_batch_window;
+        size_t _pool_workers,
+               _pool_max_queued;
+        size_t _pool_limits[prio_classes];
+        size_t          _connect_nodes;
+        time_value_type _connect_timeout,
+                        _node_timeout,
+                        _connect_poll_min,
+                        _connect_poll_max;
+        size_t          _cache_max_entries,
+                        _cache_max_bytes;
+        time_value_type _cache_ttl;
+        bool            _find_dedup;
+        unsigned long   _find_dedup_hits;
+        bool            _find_view;
                
         typedef map<task *, task *> running_tasks_type;
         typedef list<observer_info> message_obsvs_type;
+        // Observers interested only in messages from a specific task
+        typedef map<task *, message_obsvs_type>    task_obsvs_type;
+        // Tasks that have observers with the handler
+        typedef multimap<notify_handler *, task *> handler_index_type;
+        // Searches that are running, by KadC index of the key
+        typedef map<key128, task *>                running_finds_type;
+        // Searches whose results event observers do not want anymore,
+        // by task and the key's item in find_many()
+        typedef set<pair<task *, size_t> >         unobserved_type;
         
         running_tasks_type _running_tasks;
         message_queue_type _msg_queue;
+        // Observers for messages from any task
         message_obsvs_type _msg_observers;
+        task_obsvs_type    _task_observers;
+        handler_index_type _handler_index;
+        running_finds_type _running_finds;
+        unobserved_type    _unobserved;
+        // Runs find and store tasks, NULL if each task gets its own thread
+        task_pool         *_pool;
+        // Limits the KadC calls of the tasks
+        admission          _admission;
+        // Results of finished searches, NULL if caching is not enabled
+        result_cache      *_cache;
 
         class reactor_event_handler *_rehandler;
+        // Reactor timer flushing the result batches of searches, 
+        // -1 if not scheduled
+        long                         _batch_timer;
         
         class state *_state;
         int          _state_out;
@@ -108,6 +157,16 @@ namespace kadc {
         // Changes state that can be queried by application
         void _change_state_out(int t);
         void _task_add(task *t);
+        void _task_submit(task *t);
+        void _task_submit_parts(class task_parts *t);
+        void _task_run(task *t);
+        task *_running_find(const key128 &index);
+        void  _running_find_add(const key128 &index, task *t);
+        void  _running_find_done(task *t);
+        void  _quit_search(task *t);
+        bool  _search_observed(task *t);
+        // Whether a handler still receives the results of the search
+        bool  _search_handled(task *t);
         void _quit_all_tasks();
         void _wait_running_tasks();
         void _quit_task(task *t);
@@ -120,7 +179,13 @@ namespace kadc {
         inline void _kadc_started(bool t) { _kstarted = t; }
         
         void _process_queue();
+        void _batch_timer_start();
+        void _batch_timer_cancel();
+        void _flush_batches();
         void _process_msg(message *tm);
+        void _dispatch_msg(message *tm, message_obsvs_type *obsvs);
+        void _notify_search_result(message *tm);
+        void _unindex_handler(notify_handler *h, task *t);
     public:
         /// @cond KADC_INTERNAL
         const static int msg_connect       = 1;
@@ -129,8 +194,24 @@ namespace kadc {
         const static int msg_search_result = 4;
         const static int msg_search_done   = 5;
         const static int msg_task_exit     = 6;
+        const static int msg_search_batch  = 7;
+        const static int msg_store_item    = 8;
+        const static int msg_search_many_result = 9;
+        const static int msg_search_key_done    = 10;
+        const static int msg_search_many_done   = 11;
+        const static int msg_search_view        = 12;
+        
+        inline result_cache *find_cache() { return _cache; }
+        inline admission    *kadc_admission() { return &_admission; }
         /// @endcond
         
+        /**
+         * Error code given to failure() of operations that were 
+         * rejected because too many KadC calls or threads were 
+         * running, see the kadc_admission option of init().
+         */
+        const static int error_rejected = 1;
+        
         client();
         virtual ~client();
 
@@ -139,11 +220,105 @@ namespace kadc {
          */
         inline const char *init_file() { return _init_file.c_str(); }
         
+        /**
+         * @brief returns the file where contacts are snapshotted
+         * 
+         * By default init_file() with ".snapshot" appended.
+         */
+        inline const string &snapshot_file() const { return _snapshot_file; }
+        /**
+         * @brief returns interval of writing contacts to the 
+         *        snapshot file, zero if not written
+         */
+        inline const time_value_type &snapshot_interval() const {
+            return _snapshot_interval;
+        }
+        
         /**
          * @brief Initialisation of KadC
          * 
          * Supported keys in dht::kadc::client:
          * - init_file
+         * - snapshot_interval: seconds between writing KadC's contacts
+         *   to snapshot_file while connected (default 0, not written).
+         *   When connecting, the snapshot is used instead of init_file 
+         *   if it exists, since contacts of the last session are 
+         *   likely to respond. KadC writes its contacts back to the
+         *   file it was started with, so init_file is then not
+         *   updated on disconnect.
+         * - snapshot_file: see snapshot_file()
+         * - connect_nodes: number of contacted nodes after which the
+         *   client is connected (default 20, at least 1). Lower 
+         *   values make connecting faster on hosts that bootstrap 
+         *   quickly, but the first operations may then find less.
+         * - connect_timeout: seconds after which connecting fails if no
+         *   nodes have been contacted, or succeeds if some have 
+         *   (default 120)
+         * - node_timeout: seconds after the first contacted node after
+         *   which the client is connected even if there are less 
+         *   than connect_nodes nodes (default 30)
+         * - connect_poll_min, connect_poll_max: interval in 
+         *   milliseconds of checking the number of nodes while 
+         *   connecting (default 50 and 500, at least 1). Polling 
+         *   starts at the minimum and doubles up to the maximum while
+         *   the number of nodes stays the same.
+         * - task_pool_size: number of prespawned worker threads
+         *   that run find and store operations (default 16). If 0, 
+         *   each operation is run in a thread of its own.
+         * - task_queue_size: maximum number of find and store operations
+         *   waiting for a free worker thread (default 1024, 0 for 
+         *   unlimited). If the queue is full find() and store() throw
+         *   operation_error.
+         * - task_pool_limit_interactive, task_pool_limit_normal,
+         *   task_pool_limit_background: maximum number of workers 
+         *   running operations of the priority_class at the same 
+         *   time, 0 for no limit. By default only background 
+         *   operations are limited, to half of task_pool_size, so
+         *   that workers are left for interactive finds. Queued 
+         *   operations of a higher class are always started first.
+         * - kadc_max_calls: maximum number of KadC searches and 
+         *   publishes running at the same time, from all find and 
+         *   store operations (default 0, unlimited). find_many() and
+         *   store_many() make one call per key being searched or 
+         *   published.
+         * - kadc_max_threads: maximum number of KadC threads used by
+         *   the running calls together (default 0, unlimited). A call
+         *   asking for more threads than this gets this many.
+         * - kadc_admission: what is done to calls over the limits.
+         *   "queue" (default) makes them wait for running calls to
+         *   return, until the deadline of the operation if it has 
+         *   one. "reject" fails them at once with error code 
+         *   error_rejected.
+         * - find_batch_size: see find_batch_size()
+         * - find_batch_window: see find_batch_window(), in milliseconds
+         * - find_cache_size: maximum number of keys whose search 
+         *   results are cached (default 0). Results of a completed
+         *   search are cached, and a find() of a cached key delivers
+         *   them on the next process() call without searching. 
+         *   Storing a value with a key removes it from the cache.
+         * - find_cache_memory: maximum number of bytes used by the
+         *   cached results (default 0, unlimited). If only this
+         *   is set, the number of keys is not limited.
+         * - find_cache_ttl: seconds the results are cached (default 300)
+         * - store_many_threads: see store_many_threads()
+         * - find_many_threads: see find_many_threads()
+         * - find_dedup: if 1, a find() of a key that is already being
+         *   searched does not start a new search (default 0).
+         *   Instead the handler gets the results of the running 
+         *   search from then on and its completion, but not the
+         *   results the search delivered before the handler was 
+         *   attached. Cancelling the handler does not stop the search
+         *   for the other handlers.
+         * - find_view: if 1, results of find() are delivered with
+         *   search_handler::found_view() instead of found() or 
+         *   found_batch() (default 0). The tags of each result are 
+         *   then copied once from KadC to a buffer of the result
+         *   message, and decoded only when the handler asks for them.
+         *   Observers and handlers that do not override found_view()
+         *   get copies. Results answered from the result cache and
+         *   results of find_many() are delivered as values. With 
+         *   find_cache_size the raw records are also kept for the
+         *   cache, and decoded to values once when a search completes.
          */
         virtual void init(const name_value_map &opts);
         
@@ -168,12 +343,90 @@ namespace kadc {
         virtual void connect(dht::notify_handler    *handler = NULL);
         virtual void disconnect(dht::notify_handler *handler = NULL);
         
+        /**
+         * @brief Searches the DHT
+         * 
+         * The KadC search ends before find_duration when no handler
+         * or observer wants its results anymore: the handlers have 
+         * returned non-zero from found() or been cancelled with 
+         * handler_cancel(), and no observer is set for search results.
+         * This frees the KadC threads and sockets of the search. 
+         * Results KadC already had in flight are not delivered.
+         * find_many() ends the search of a single key the same way.
+         * 
+         * @see dht::client::find()
+         */
         virtual void find(const dht::key      &fkey,
                           dht::search_handler *handler);
+        /**
+         * @brief Searches the DHT with parameters of its own
+         * 
+         * A search with other than the client's default parameters
+         * is not shared with other find() calls of the same key,
+         * see the find_dedup option of init(). 
+         * 
+         * @see find_params
+         */
+        void find(const dht::key      &fkey,
+                  dht::search_handler *handler,
+                  const find_params   &params);
+        /**
+         * @brief Searches the DHT, moving the key into the search task
+         * 
+         * If the search is shared with a running search of the same 
+         * key, the key is not needed and is left as it was.
+         * 
+         * @see dht::client::find_move()
+         */
+        virtual void find_move(dht::key            *fkey,
+                               dht::search_handler *handler);
+        void find_move(dht::key            *fkey,
+                       dht::search_handler *handler,
+                       const find_params   &params);
+
+        /**
+         * @brief Searches many keys as one operation
+         * 
+         * The keys are searched by find_many_threads() tasks of the
+         * task pool, each searching one key at a time. The tasks wait
+         * in the normal priority class, and each search is admitted
+         * like a find().
+         * Cached results are used like with find(), but searches are
+         * not shared with find() calls of the same key.
+         * 
+         * @see dht::client::find_many()
+         */
+        virtual void find_many(const dht::key      *begin,
+                               const dht::key      *end,
+                               dht::search_handler *handler);
 
         virtual void store(const dht::key      &skey,
                            const dht::value    &svalue,
                            dht::notify_handler *handler = NULL);
+        /**
+         * @brief Stores a value with parameters of its own
+         * @see store_params
+         */
+        void store(const dht::key      &skey,
+                   const dht::value    &svalue,
+                   dht::notify_handler *handler,
+                   const store_params  &params);
+
+        /**
+         * @brief Stores many values as one operation
+         * 
+         * The pairs are published by store_many_threads() tasks of
+         * the task pool, each publishing one pair at a time. The 
+         * tasks wait in the priority class of store() and count 
+         * against its limit, and each publishing is admitted like
+         * a store(). The handler is notified once all pairs have 
+         * been published.
+         * 
+         * @see dht::client::store_many()
+         */
+        virtual void store_many(const key_value          *begin,
+                                const key_value          *end,
+                                dht::store_many_handler *handler = NULL);
 
         virtual const addr_inet_type &external_addr();
 
@@ -183,6 +436,22 @@ namespace kadc {
         virtual void          reactor(reactor_type *reactor);
         virtual int handler_cancel(notify_handler *handler);
 
+        /// @cond KADC_INTERNAL
+        inline size_t connect_nodes() const { return _connect_nodes; }
+        inline const time_value_type &connect_timeout() const { 
+            return _connect_timeout; 
+        }
+        inline const time_value_type &node_timeout() const { 
+            return _node_timeout; 
+        }
+        inline const time_value_type &connect_poll_min() const { 
+            return _connect_poll_min; 
+        }
+        inline const time_value_type &connect_poll_max() const { 
+            return _connect_poll_max; 
+        }
+        /// @endcond
+
         /**
          * @brief Sets number of threads used for find operations
          * @param t number of threads to use or 0 for KadC default
@@ -215,6 +484,25 @@ namespace kadc {
          */
         inline size_t find_duration() const { return _find_duration; }
 
+        /**
+         * @brief Sets number of keys find_many() searches at once
+         * @param t number of pool tasks, each searching one key at a 
+         *          time
+         * 
+         * Each search uses find_threads() KadC threads. 
+         * The default is 4.
+         */
+        inline size_t find_many_threads(size_t t) {
+            t = std::min<size_t>(t, 64);
+            return _find_many_threads = std::max<size_t>(t, 1);
+        }
+        /**
+         * @brief Gets number of keys find_many() searches at once
+         */
+        inline size_t find_many_threads() const { 
+            return _find_many_threads; 
+        }
+
         /// @cond KADC_DEPRECATED
         inline size_t find_max_hits(size_t t) {
             return _find_max_hits = std::min<size_t>(t, 20);
@@ -223,6 +511,49 @@ namespace kadc {
         inline size_t find_max_hits() const { return _find_max_hits; }
         /// @endcond
 
+        /**
+         * @brief Sets maximum number of search results delivered at once
+         * @param n number of results, 0 or 1 to deliver each result 
+         *          separately
+         * 
+         * Search results are collected and delivered to 
+         * search_handler::found_batch() when n results have been 
+         * collected, when find_batch_window() has passed from the 
+         * first result of the batch, or when the search is finished.
+         * The window is checked by a reactor timer, so a batch may 
+         * wait up to about two windows when results come slowly.
+         */
+        inline size_t find_batch_size(size_t n) {
+            return _find_batch_size = n;
+        }
+        /**
+         * @brief Gets maximum number of search results delivered at once
+         */
+        inline size_t find_batch_size() const { return _find_batch_size; }
+        
+        /**
+         * @brief Gets whether results of find() are delivered as views
+         * @see init(), search_handler::found_view()
+         */
+        inline bool find_view() const { return _find_view; }
+        
+        /**
+         * @brief Sets how long search results are collected into a batch
+         * @param t time after the first result of a batch
+         * 
+         * Only used if find_batch_size() is more than 1.
+         */
+        inline const time_value_type &
+        find_batch_window(const time_value_type &t) {
+            return _find_batch_window = t;
+        }
+        /**
+         * @brief Gets how long search results are collected into a batch
+         */
+        inline const time_value_type &find_batch_window() const { 
+            return _find_batch_window; 
+        }
+
         /**
          * @brief Sets number of threads used for store operations
          * @param t number of threads to use or 0 for KadC default
@@ -240,6 +571,20 @@ namespace kadc {
          * Can be 0 for default value.
          */
         inline size_t store_threads() const { return _store_threads; }
+        
+        /**
+         * @brief Fills the fields of params left 0 with the client's
+         *        find parameters
+         * 
+         * The priority of find() is prio_interactive and the priority 
+         * of store() prio_background unless set in params.
+         */
+        void find_defaults(find_params *params) const;
+        /**
+         * @brief Fills the fields of params left 0 with the client's
+         *        store parameters
+         */
+        void store_defaults(store_params *params) const;
 
         /**
          * @brief Sets the duration of store operation in seconds
@@ -255,6 +600,150 @@ namespace kadc {
          */
         inline size_t store_duration() const { return _store_duration; }
         
+        /**
+         * @brief Sets number of pairs store_many() publishes at once
+         * @param t number of pool tasks, each publishing one pair at 
+         *          a time
+         * 
+         * Each publishing uses store_threads() KadC threads. 
+         * The default is 4.
+         */
+        inline size_t store_many_threads(size_t t) {
+            t = std::min<size_t>(t, 64);
+            return _store_many_threads = std::max<size_t>(t, 1);
+        }
+        /**
+         * @brief Gets number of pairs store_many() publishes at once
+         */
+        inline size_t store_many_threads() const { 
+            return _store_many_threads; 
+        }
+        
+        /**
+         * @brief Gets number of worker threads running find and store
+         *        operations
+         * 
+         * 0 if each operation is run in a thread of its own.
+         */
+        size_t task_pool_size() const;
+        /**
+         * @brief Gets number of worker threads currently running an 
+         *        operation
+         */
+        size_t task_pool_busy() const;
+        /**
+         * @brief Gets highest number of worker threads that have been 
+         *        running an operation at the same time
+         */
+        size_t task_pool_peak_busy() const;
+        /**
+         * @brief Gets number of operations waiting for a free worker thread
+         */
+        size_t task_pool_queued() const;
+        /**
+         * @brief Gets number of operations of a priority_class waiting 
+         *        for a free worker thread
+         */
+        size_t task_pool_queued(int prio) const;
+        /**
+         * @brief Gets maximum number of workers running operations of 
+         *        a priority_class, 0 if not limited
+         */
+        size_t task_pool_limit(int prio) const;
+        /**
+         * @brief Gets how long operations of a priority_class have 
+         *        waited for a worker thread
+         * 
+         * Covers the operations started since init() or the last 
+         * task_pool_queue_wait_reset(). The average wait is 
+         * total / started.
+         */
+        queue_wait_stats task_pool_queue_wait(int prio) const;
+        void task_pool_queue_wait_reset();
+        
+        /**
+         * @brief Gets number of KadC calls running now
+         */
+        size_t kadc_calls() const;
+        /**
+         * @brief Gets number of KadC threads used by the running calls
+         */
+        size_t kadc_threads() const;
+        /**
+         * @brief Gets number of KadC calls waiting for admission
+         */
+        size_t kadc_calls_waiting() const;
+        /**
+         * @brief Gets number of KadC calls rejected because of the 
+         *        limits with the "reject" admission policy
+         */
+        unsigned long kadc_calls_rejected() const;
+        /**
+         * @brief Gets number of KadC calls whose operation's deadline
+         *        passed while waiting for admission
+         */
+        unsigned long kadc_calls_expired() const;
+        
+        /**
+         * @brief Gets number of times KadC threads have woken up 
+         *        the reactor to deliver results
+         */
+        unsigned long reactor_wakeups() const;
+        /**
+         * @brief Gets number of reactor wake ups that were not needed 
+         *        because the reactor had already been woken up
+         * 
+         * Results arriving in bursts are delivered with one wake up.
+         */
+        unsigned long reactor_wakeups_saved() const;
+        
+        /**
+         * @brief Gets number of internal messages (one is created for 
+         *        each search result) that had to be allocated from heap
+         * 
+         * Messages are reused from a pool, so this should not grow once
+         * the pool has warmed up. The count is shared by all 
+         * client instances.
+         */
+        static unsigned long message_heap_allocations();
+        /**
+         * @brief Gets number of internal messages that were returned to 
+         *        heap because the pool had enough free messages
+         */
+        static unsigned long message_heap_frees();
+        
+        /**
+         * @brief Gets number of find() calls that were attached to an
+         *        already running search of the same key
+         */
+        inline unsigned long find_dedup_hits() const { 
+            return _find_dedup_hits; 
+        }
+        
+        /**
+         * @brief Gets number of find() calls answered from the 
+         *        result cache
+         */
+        unsigned long find_cache_hits() const;
+        /**
+         * @brief Gets number of find() calls that had to search 
+         *        because the key was not cached or had expired
+         */
+        unsigned long find_cache_misses() const;
+        /**
+         * @brief Gets number of cached keys removed to make room for 
+         *        new ones
+         */
+        unsigned long find_cache_evictions() const;
+        /**
+         * @brief Gets number of keys in the result cache
+         */
+        size_t find_cache_entries() const;
+        /**
+         * @brief Removes all results from the result cache
+         */
+        void find_cache_clear();
+
         /**
          * @brief Writes KadC's initialization file to disk
          * @param target_file Path to file or if not specified/NULL 
@@ -0,0 +1,277 @@
+#include <ace/OS_NS_stdio.h>
+#include <ace/OS_NS_string.h>
+#include <ace/OS_NS_fcntl.h>
+
+#include <string.h>
+
+#include "../exception.h"
+#include "contact_file.h"
+
+using namespace std;
+
+namespace dht {
+namespace kadc {
+
+static const char magic[8] = { 'D', 'H', 'T', 'K', 'A', 'D', 'C', '\0' };
+
+static inline void
+put32(unsigned char *p, unsigned long v) {
+    p[0] = (unsigned char)(v >> 24);
+    p[1] = (unsigned char)(v >> 16);
+    p[2] = (unsigned char)(v >> 8);
+    p[3] = (unsigned char)v;
+}
+
+static inline unsigned long
+get32(const unsigned char *p) {
+    return ((unsigned long)p[0] << 24) | ((unsigned long)p[1] << 16) |
+           ((unsigned long)p[2] << 8)  |  (unsigned long)p[3];
+}
+
+static inline int
+hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Parses a decimal number of at most max, advances p past it
+static inline bool
+parse_number(const char **p, unsigned long max, unsigned long *result) {
+    const char *s = *p;
+    unsigned long v = 0;
+    if (*s < '0' || *s > '9') return false;
+    for (; *s >= '0' && *s <= '9'; s++) {
+        v = v * 10 + (*s - '0');
+        if (v > max) return false;
+    }
+    *p = s;
+    *result = v;
+    return true;
+}
+
+static inline void
+skip_space(const char **p) {
+    while (**p == ' ' || **p == '\t') (*p)++;
+}
+
+contact_file::contact_file() 
+  : _contacts(NULL), _blacklisted(NULL), _ncontacts(0), _nblacklisted(0)
+{
+}
+
+contact_file::~contact_file() {
+    close();
+}
+
+void
+contact_file::open(const char *path) {
+    close();
+    if (_map.map(path, static_cast<size_t>(-1), O_RDONLY, 0, 
+                 PROT_READ, ACE_MAP_PRIVATE) == -1)
+        throw io_errorf("Could not map contact file %s", path);
+    
+    const unsigned char *base = (const unsigned char *)_map.addr();
+    size_t               size = _map.size();
+    
+    if (size < header_size || memcmp(base, magic, sizeof(magic)) != 0) {
+        close();
+        throw io_errorf("%s is not a contact file", path);
+    }
+    if (get32(base + 8) != version || get32(base + 12) != record_size) {
+        close();
+        throw io_errorf("Contact file %s has unsupported version %lu", 
+                        path, get32(base + 8));
+    }
+    size_t ncontacts    = get32(base + 16);
+    size_t nblacklisted = get32(base + 20);
+    size_t local_size   = get32(base + 24);
+    // Each count is checked before they are added, so that the sum
+    // cannot wrap with a 32-bit size_t
+    size_t max_records  = (size - header_size) / record_size;
+    if (ncontacts > max_records || 
+        nblacklisted > max_records - ncontacts ||
+        size - header_size - (ncontacts + nblacklisted) * record_size < 
+          local_size)
+    {
+        close();
+        throw io_errorf("Contact file %s is truncated", path);
+    }
+    
+    _ncontacts    = ncontacts;
+    _nblacklisted = nblacklisted;
+    _contacts     = (const record *)(base + header_size);
+    _blacklisted  = _contacts + _ncontacts;
+    _local.assign((const char *)(_blacklisted + _nblacklisted), local_size);
+}
+
+void
+contact_file::close() {
+    if (_contacts == NULL && _map.addr() == NULL) return;
+    _map.close();
+    _contacts     = _blacklisted = NULL;
+    _ncontacts    = _nblacklisted = 0;
+    _local.erase();
+}
+
+void
+contact_file::write(const char *path,
+                    const records_type &contacts,
+                    const records_type &blacklisted,
+                    const string       &local)
+{
+    unsigned char header[header_size];
+    memset(header, 0, sizeof(header));
+    memcpy(header, magic, sizeof(magic));
+    put32(header + 8,  version);
+    put32(header + 12, record_size);
+    put32(header + 16, contacts.size());
+    put32(header + 20, blacklisted.size());
+    put32(header + 24, local.size());
+    
+    string tmp = string(path) + ".tmp";
+    FILE *fp = ACE_OS::fopen(tmp.c_str(), "wb");
+    if (fp == NULL)
+        throw io_errorf("Could not open %s for writing", tmp.c_str());
+    
+    bool ok = ACE_OS::fwrite(header, sizeof(header), 1, fp) == 1;
+    if (ok && !contacts.empty())
+        ok = ACE_OS::fwrite(&contacts[0], record_size, contacts.size(), fp)
+             == contacts.size();
+    if (ok && !blacklisted.empty())
+        ok = ACE_OS::fwrite(&blacklisted[0], record_size, 
+                            blacklisted.size(), fp) == blacklisted.size();
+    if (ok && !local.empty())
+        ok = ACE_OS::fwrite(local.data(), local.size(), 1, fp) == 1;
+    if (ACE_OS::fclose(fp) != 0) ok = false;
+    
+    if (!ok || ACE_OS::rename(tmp.c_str(), path) == -1) {
+        ACE_OS::unlink(tmp.c_str());
+        throw io_errorf("Could not write contact file %s", path);
+    }
+}
+
+bool
+contact_file::parse_line(const char *line, record *r) {
+    const char *p = line;
+    skip_space(&p);
+    for (int i = 0; i < 16; i++) {
+        int h = hex_value(p[0]);
+        int l = (h < 0 ? -1 : hex_value(p[1]));
+        if (l < 0) return false;
+        r->id[i] = (unsigned char)((h << 4) | l);
+        p += 2;
+    }
+    if (*p != ' ' && *p != '\t') return false;
+    skip_space(&p);
+    
+    unsigned long v;
+    for (int i = 0; i < 4; i++) {
+        if (!parse_number(&p, 255, &v)) return false;
+        r->ip[i] = (unsigned char)v;
+        if (i < 3 && *p++ != '.') return false;
+    }
+    skip_space(&p);
+    if (!parse_number(&p, 65535, &v)) return false;
+    r->port[0] = (unsigned char)(v >> 8);
+    r->port[1] = (unsigned char)v;
+    skip_space(&p);
+    if (!parse_number(&p, 255, &v)) return false;
+    r->type     = (unsigned char)v;
+    r->reserved = 0;
+    return true;
+}
+
+void
+contact_file::format_line(const record &r, string *line) {
+    static const char hex[] = "0123456789abcdef";
+    // 32 hex + 4 * 4 ip + 6 port + 4 type
+    char  buf[64];
+    char *p = buf;
+    for (int i = 0; i < 16; i++) {
+        *p++ = hex[r.id[i] >> 4];
+        *p++ = hex[r.id[i] & 0x0f];
+    }
+    p += sprintf(p, " %u.%u.%u.%u %u %u", 
+                 r.ip[0], r.ip[1], r.ip[2], r.ip[3],
+                 (r.port[0] << 8) | r.port[1], r.type);
+    line->assign(buf, p - buf);
+}
+
+void
+contact_file::read_ini(const char *path, 
+                       records_type *contacts,
+                       records_type *blacklisted,
+                       string       *local)
+{
+    FILE *fp = ACE_OS::fopen(path, "r");
+    if (fp == NULL)
+        throw io_errorf("Could not open %s for reading", path);
+    
+    enum { other, in_local, in_peers, in_blacklisted } section = other;
+    char   line[512];
+    record r;
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        if (line[0] == '[') {
+            if      (strncmp(line, "[local]", 7) == 0) 
+                section = in_local;
+            else if (strncmp(line, "[overnet_peers]", 15) == 0) 
+                section = in_peers;
+            else if (strncmp(line, "[blacklisted_nodes]", 19) == 0)
+                section = in_blacklisted;
+            else 
+                section = other;
+            continue;
+        }
+        switch (section) {
+        case in_local:
+            local->append(line);
+            break;
+        case in_peers:
+            if (line[0] != '#' && parse_line(line, &r)) 
+                contacts->push_back(r);
+            break;
+        case in_blacklisted:
+            if (line[0] != '#' && parse_line(line, &r)) 
+                blacklisted->push_back(r);
+            break;
+        default:
+            break;
+        }
+    }
+    ACE_OS::fclose(fp);
+}
+
+void
+contact_file::write_ini(const char *path,
+                        const records_type &contacts,
+                        const records_type &blacklisted,
+                        const string       &local)
+{
+    FILE *fp = ACE_OS::fopen(path, "w");
+    if (fp == NULL)
+        throw io_errorf("Could not open %s for writing", path);
+    
+    string line;
+    bool   ok = fprintf(fp, "[local]\n%s[overnet_peers]\n"
+                            "# %lu contacts follow\n", 
+                        local.c_str(), (unsigned long)contacts.size()) > 0;
+    records_type::const_iterator i = contacts.begin();
+    for (; ok && i != contacts.end(); i++) {
+        format_line(*i, &line);
+        line += '\n';
+        ok = ACE_OS::fwrite(line.data(), line.size(), 1, fp) == 1;
+    }
+    if (ok) ok = fputs("[blacklisted_nodes]\n", fp) >= 0;
+    for (i = blacklisted.begin(); ok && i != blacklisted.end(); i++) {
+        format_line(*i, &line);
+        line += '\n';
+        ok = ACE_OS::fwrite(line.data(), line.size(), 1, fp) == 1;
+    }
+    if (ACE_OS::fclose(fp) != 0) ok = false;
+    if (!ok) throw io_errorf("Could not write %s", path);
+}
+
+} // ns kadc
+} // ns dht
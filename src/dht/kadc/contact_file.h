@@ -0,0 +1,124 @@
+#ifndef DHT_KADC_CONTACT_FILE_H_
+#define DHT_KADC_CONTACT_FILE_H_
+
+#include <ace/Mem_Map.h>
+
+#include <string>
+#include <vector>
+
+namespace dht {
+namespace kadc {
+    /**
+     * @class contact_file contact_file.h dht/kadc/contact_file.h
+     * @brief Binary file of KadC contacts that is loaded by mapping
+     *        it to memory
+     * 
+     * KadC's init file lists contacts as text lines 
+     * (hex-id ip port type). This format holds the same contacts as 
+     * fixed size records, so that loading the file does not require
+     * parsing: the file is memory-mapped and the records are used 
+     * in place.
+     * 
+     * Layout, all integers in network byte order:
+     * - header of 32 bytes: magic "DHTKADC\0", version (4 bytes), 
+     *   record size (4 bytes), number of contacts (4 bytes), number 
+     *   of blacklisted nodes (4 bytes), length of the local 
+     *   section (4 bytes), reserved (4 bytes)
+     * - contact records, 24 bytes each
+     * - blacklisted node records, 24 bytes each
+     * - text of the [local] section of the init file
+     * 
+     * Functions for converting to and from the init file format are
+     * provided, since KadC itself reads only the init file.
+     */
+    class contact_file {
+    public:
+        /**
+         * @brief A contact, 24 bytes with no padding
+         */
+        struct record {
+            unsigned char id[16];
+            unsigned char ip[4];     // network byte order
+            unsigned char port[2];   // network byte order
+            unsigned char type;
+            unsigned char reserved;
+        };
+        typedef std::vector<record> records_type;
+        
+        const static size_t header_size = 32;
+        const static size_t record_size = 24;
+        const static unsigned int version = 1;
+    private:
+        ACE_Mem_Map          _map;
+        const record        *_contacts;
+        const record        *_blacklisted;
+        size_t               _ncontacts;
+        size_t               _nblacklisted;
+        std::string          _local;
+        
+        contact_file(const contact_file &);
+        contact_file &operator=(const contact_file &);
+    public:
+        contact_file();
+        ~contact_file();
+        
+        /**
+         * @brief Maps a contact file to memory
+         * @exception io_error if the file can not be mapped or is not
+         *            a valid contact file
+         */
+        void open(const char *path);
+        void close();
+        
+        inline size_t        contacts() const    { return _ncontacts; }
+        inline const record *contact(size_t i) const { 
+            return _contacts + i; 
+        }
+        inline size_t        blacklisted() const { return _nblacklisted; }
+        inline const record *blacklisted(size_t i) const { 
+            return _blacklisted + i; 
+        }
+        /**
+         * @brief Lines of the [local] section of the init file
+         */
+        inline const std::string &local() const { return _local; }
+        
+        /**
+         * @brief Writes a contact file
+         * @exception io_error if writing fails
+         * 
+         * The file is written to a temporary file first and renamed,
+         * so readers never see a partially written file.
+         */
+        static void write(const char *path,
+                          const records_type &contacts,
+                          const records_type &blacklisted,
+                          const std::string  &local);
+
+        /**
+         * @brief Reads contacts from KadC's init file
+         * @exception io_error if the file can not be read
+         * 
+         * Lines that can not be parsed are skipped.
+         */
+        static void read_ini(const char *path, 
+                             records_type *contacts,
+                             records_type *blacklisted,
+                             std::string  *local);
+        /**
+         * @brief Writes contacts in KadC's init file format
+         * @exception io_error if writing fails
+         */
+        static void write_ini(const char *path,
+                              const records_type &contacts,
+                              const records_type &blacklisted,
+                              const std::string  &local);
+        
+        // Converts one line of the init file (hex-id ip port type)
+        static bool parse_line(const char *line, record *r);
+        static void format_line(const record &r, std::string *line);
+    };
+} // ns kadc
+} // ns dht
+
+#endif //DHT_KADC_CONTACT_FILE_H_
@@ -0,0 +1,59 @@
+#ifndef DHT_KADC_KEY128_H_
+#define DHT_KADC_KEY128_H_
+
+#include <string.h>
+
+namespace dht {
+namespace kadc {
+    /**
+     * @class key128 key128.h dht/kadc/key128.h
+     * @brief 128-bit hash used by KadC as the index of keys and values
+     * 
+     * Kept in binary form from the point the hash of a key is 
+     * computed. KadC's API takes the hash as a "#" prefixed hex 
+     * string, which is formatted only when calling KadC, into a 
+     * buffer on the stack.
+     */
+    class key128 {
+        unsigned char _h[16];
+    public:
+        const static size_t size = 16;
+        // "#", 32 hex digits and terminating NUL
+        const static size_t kadc_index_size = 34;
+        
+        inline key128() { memset(_h, 0, sizeof(_h)); }
+        inline explicit key128(const unsigned char *h) { 
+            memcpy(_h, h, sizeof(_h)); 
+        }
+        
+        inline unsigned char       *data()       { return _h; }
+        inline const unsigned char *data() const { return _h; }
+        
+        /**
+         * @brief Formats the index string given to KadC
+         * @param buf buffer of at least kadc_index_size characters
+         */
+        inline void kadc_index(char *buf) const {
+            static const char hex[] = "0123456789abcdef";
+            *buf++ = '#';
+            for (size_t i = 0; i < sizeof(_h); i++) {
+                *buf++ = hex[_h[i] >> 4];
+                *buf++ = hex[_h[i] & 0x0f];
+            }
+            *buf = '\0';
+        }
+        
+        inline bool operator<(const key128 &o) const {
+            return memcmp(_h, o._h, sizeof(_h)) < 0;
+        }
+        inline bool operator==(const key128 &o) const {
+            return memcmp(_h, o._h, sizeof(_h)) == 0;
+        }
+        inline bool operator!=(const key128 &o) const {
+            return !(*this == o);
+        }
+    };
+} // ns kadc
+} // ns dht
+
+#endif //DHT_KADC_KEY128_H_
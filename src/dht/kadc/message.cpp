@@ -1,4 +1,11 @@
+#include <algorithm>
+
 #include "message.h"
+#include "message_search.h"
+#include "message_search_batch.h"
+#include "message_search_many.h"
+#include "message_search_view.h"
+#include "message_store.h"
 
 namespace dht {
 namespace kadc {
@@ -7,5 +14,27 @@ message::~message() {
     
 }
 
+object_pool &
+message::pool() {
+    // Blocks are big enough for every message type that is created
+    // for each search result or stored value
+    static object_pool p(std::max(std::max(sizeof(message_search_many), 
+                                           sizeof(message_search)),
+                                  std::max(std::max(sizeof(message_search_batch),
+                                                    sizeof(message_search_view)),
+                                           sizeof(message_store))));
+    return p;
+}
+
+void *
+message::operator new(size_t size) {
+    return pool().allocate(size);
+}
+
+void
+message::operator delete(void *p, size_t size) {
+    pool().deallocate(p, size);
+}
+
 } // ns kadc
 } // ns dht
@@ -3,10 +3,12 @@
 
 #include "../notify_handler.h"
 #include "task.h"
+#include "mpsc_queue.h"
+#include "object_pool.h"
 
 namespace dht {
 namespace kadc {
-    class message {
+    class message : public mpsc_node {
         task           *_from;
         int             _msg_type;
         int             _code;
@@ -26,6 +28,13 @@ namespace kadc {
 
         virtual ~message();
         
+        // Messages and the classes derived from it are allocated from
+        // a pool, since they are created in KadC threads and deleted 
+        // in the reactor thread in large numbers.
+        static void *operator new(size_t size);
+        static void  operator delete(void *p, size_t size);
+        static object_pool &pool();
+        
         inline int  type() const { return _msg_type; }
         inline void type(int t)  { _msg_type = t; }
 
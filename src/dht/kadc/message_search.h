@@ -10,13 +10,14 @@ namespace dht {
 namespace kadc {
     class message_search : public message {
         key     *_skey;   // search key
-        value   *_rvalue; // result value
+        // Result value is part of the message so that it is allocated 
+        // from the message pool together with it.
+        value    _rvalue;
 
     public:
         message_search(task *f, int type) : message(f, type)
         {
             _skey   = NULL;
-            _rvalue = NULL;
         }
 
         virtual ~message_search();
@@ -24,8 +25,8 @@ namespace kadc {
         inline const key  *search_key() const { return _skey; }
         inline void        search_key(key *k) { _skey = k; }
 
-        inline const value *result_value() const   { return _rvalue; }
-        inline void         result_value(value *v) { _rvalue = v; }
+        inline const value *result_value() const { return &_rvalue; }
+        inline value       *result_value()       { return &_rvalue; }
     };      
 } // ns kadc
 } // ns dht
@@ -0,0 +1,10 @@
+#include "message_search_batch.h"
+
+namespace dht {
+namespace kadc {
+
+message_search_batch::~message_search_batch() {
+}
+
+} // ns kadc
+} // ns dht
@@ -0,0 +1,33 @@
+#ifndef DHT_KADC_MESSAGE_SEARCH_BATCH_H_
+#define DHT_KADC_MESSAGE_SEARCH_BATCH_H_
+
+#include <vector>
+
+#include "../value.h"
+
+#include "message_search.h"
+
+namespace dht {
+namespace kadc {
+    // Several results of one search delivered with one message
+    class message_search_batch : public message_search {
+    public:
+        typedef std::vector<value> values_type;
+    private:
+        values_type _rvalues;
+    public:
+        message_search_batch(task *f, int type, size_t reserve = 0) 
+          : message_search(f, type)
+        {
+            _rvalues.reserve(reserve);
+        }
+
+        virtual ~message_search_batch();
+
+        inline const values_type &result_values() const { return _rvalues; }
+        inline       values_type &result_values()       { return _rvalues; }
+    };      
+} // ns kadc
+} // ns dht
+
+#endif //DHT_KADC_MESSAGE_SEARCH_BATCH_H_
@@ -0,0 +1,10 @@
+#include "message_search_many.h"
+
+namespace dht {
+namespace kadc {
+
+message_search_many::~message_search_many() {
+}
+
+} // ns kadc
+} // ns dht
@@ -0,0 +1,24 @@
+#ifndef DHT_KADC_MESSAGE_SEARCH_MANY_H_
+#define DHT_KADC_MESSAGE_SEARCH_MANY_H_
+
+#include "message_search.h"
+
+namespace dht {
+namespace kadc {
+    // Result or completion of one key of find_many
+    class message_search_many : public message_search {
+        size_t _item;   // index of the key in the task
+    public:
+        message_search_many(task *f, int type, size_t item) 
+          : message_search(f, type), _item(item)
+        {
+        }
+
+        virtual ~message_search_many();
+
+        inline size_t item() const { return _item; }
+    };      
+} // ns kadc
+} // ns dht
+
+#endif //DHT_KADC_MESSAGE_SEARCH_MANY_H_
@@ -0,0 +1,25 @@
+#include "message_search_view.h"
+
+namespace dht {
+namespace kadc {
+
+message_search_view::~message_search_view() {
+}
+
+value_view
+message_search_view::record(size_t i) const {
+    return record(_raw, _offsets, i);
+}
+
+value_view
+message_search_view::record(const std::string  &raw,
+                            const offsets_type &offsets, size_t i)
+{
+    size_t start = offsets[i];
+    size_t end   = (i + 1 < offsets.size() ? offsets[i + 1] : raw.size());
+    const char *r = raw.data() + start;
+    return value_view(r, hash_size, r + hash_size, end - start - hash_size);
+}
+
+} // ns kadc
+} // ns dht
@@ -0,0 +1,48 @@
+#ifndef DHT_KADC_MESSAGE_SEARCH_VIEW_H_
+#define DHT_KADC_MESSAGE_SEARCH_VIEW_H_
+
+#include <string>
+#include <vector>
+
+#include "../value_view.h"
+
+#include "message_search.h"
+
+namespace dht {
+namespace kadc {
+    // Results of one search as raw records, delivered to handlers as
+    // value_views. A record is the 16 byte value hash followed by the
+    // string tags as "name\0value\0" pairs, see util::kadc_result_raw().
+    class message_search_view : public message_search {
+    public:
+        const static size_t hash_size = 16;
+        typedef std::vector<size_t> offsets_type;
+    private:
+        std::string  _raw;
+        // Start of each record in _raw
+        offsets_type _offsets;
+    public:
+        message_search_view(task *f, int type, size_t reserve = 0) 
+          : message_search(f, type)
+        {
+            _offsets.reserve(reserve);
+        }
+
+        virtual ~message_search_view();
+        
+        // Starts a new record, which is appended to raw()
+        inline std::string *record_begin() { 
+            _offsets.push_back(_raw.size());
+            return &_raw;
+        }
+        inline size_t records() const { return _offsets.size(); }
+        // The view is valid until the message is modified or deleted
+        value_view record(size_t i) const;
+        // Record i of raw records kept elsewhere, starting at offsets
+        static value_view record(const std::string  &raw,
+                                 const offsets_type &offsets, size_t i);
+    };      
+} // ns kadc
+} // ns dht
+
+#endif //DHT_KADC_MESSAGE_SEARCH_VIEW_H_
@@ -0,0 +1,12 @@
+#include "message_store.h"
+
+namespace dht {
+namespace kadc {
+
+message_store::~message_store() {
+    // key and value are not deleted, since they belong to 
+    // task_store_many and are deleted with it.
+}
+
+} // ns kadc
+} // ns dht
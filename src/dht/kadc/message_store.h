@@ -0,0 +1,38 @@
+#ifndef DHT_KADC_MESSAGE_STORE_H_
+#define DHT_KADC_MESSAGE_STORE_H_
+
+#include "../key.h"
+#include "../value.h"
+
+#include "message.h"
+
+namespace dht {
+namespace kadc {
+    // Result of storing one key/value pair of store_many
+    class message_store : public message {
+        const key   *_skey;
+        const value *_svalue;
+        int          _replicas;
+    public:
+        message_store(task *f, int type) : message(f, type)
+        {
+            _skey     = NULL;
+            _svalue   = NULL;
+            _replicas = 0;
+        }
+
+        virtual ~message_store();
+
+        // Key and value belong to the task that sent the message
+        inline const key   *store_key() const        { return _skey; }
+        inline void         store_key(const key *k)  { _skey = k; }
+        inline const value *store_value() const       { return _svalue; }
+        inline void         store_value(const value *v) { _svalue = v; }
+        
+        inline int  replicas() const { return _replicas; }
+        inline void replicas(int r)  { _replicas = r; }
+    };      
+} // ns kadc
+} // ns dht
+
+#endif //DHT_KADC_MESSAGE_STORE_H_
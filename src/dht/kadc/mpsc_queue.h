@@ -0,0 +1,106 @@
+#ifndef DHT_KADC_MPSC_QUEUE_H_
+#define DHT_KADC_MPSC_QUEUE_H_
+
+#include <stddef.h>
+
+#include "atomic.h"
+#include "reactor_event_handler.h"
+
+namespace dht {
+namespace kadc {
+    /**
+     * Link that an element must inherit from to be stored in mpsc_queue. 
+     * An element can be in only one queue at a time.
+     */
+    class mpsc_node {
+        template <class T> friend class mpsc_queue;
+        mpsc_node * volatile _mpsc_next;
+    public:
+        mpsc_node() : _mpsc_next(NULL) {}
+    };
+    
+    /**
+     * Intrusive lock-free multi-producer/single-consumer queue
+     * (D. Vyukov's algorithm).
+     * 
+     * Any number of threads can push() concurrently without ever waiting
+     * for each other or the consumer. Only one thread at a time, 
+     * normally the reactor thread, is allowed to pop(). Elements pushed
+     * by one thread are popped in the same order.
+     * 
+     * pop() can return NULL while a producer is in the middle of 
+     * a push(). The producer signals the target after pushing, so 
+     * the consumer will be woken up again to pop the element.
+     * 
+     * The queue does not own the elements. 
+     */
+    template <class T>
+    class mpsc_queue {
+        // Producers append to head, consumer takes from tail
+        mpsc_node * volatile   _head;
+        mpsc_node             *_tail;
+        mpsc_node              _stub;
+        reactor_event_handler *_target;
+        
+        inline void _push(mpsc_node *n) {
+            n->_mpsc_next = NULL;
+            mpsc_node *prev = atomic::exchange(&_head, n);
+            // Between the exchange and this store the consumer 
+            // can not see n or anything pushed after it
+            atomic::store(&prev->_mpsc_next, n);
+        }
+        
+    public:
+        mpsc_queue() : _head(&_stub), _tail(&_stub), _target(NULL) {}
+        ~mpsc_queue() {}
+        
+        inline reactor_event_handler *target()       { return _target; }
+        inline void target(reactor_event_handler *t) { _target = t; }
+        
+        // Wakes up the consumer
+        inline void signal() {
+            _target->signal();
+        }
+        
+        // Can be called from any thread
+        inline void push(T *e) { _push(e); }
+        
+        // Returns the oldest element or NULL if none available. 
+        // Must be called only from the consumer thread.
+        T *pop() {
+            mpsc_node *tail = _tail;
+            mpsc_node *next = atomic::load(&tail->_mpsc_next);
+            
+            if (tail == &_stub) {
+                if (next == NULL) return NULL;
+                _tail = tail = next;
+                next  = atomic::load(&next->_mpsc_next);
+            }
+            if (next) {
+                _tail = next;
+                return static_cast<T *>(tail);
+            }
+            // A producer is between exchange and linking
+            if (tail != atomic::load(&_head)) return NULL;
+            
+            // tail is the last element. Push stub behind it so that
+            // tail can be detached from the queue.
+            _push(&_stub);
+            next = atomic::load(&tail->_mpsc_next);
+            if (next) {
+                _tail = next;
+                return static_cast<T *>(tail);
+            }
+            return NULL;
+        }
+        
+        // Consumer side check if anything can be popped
+        inline bool empty() const {
+            return _tail == &_stub && 
+                   atomic::load(&_stub._mpsc_next) == NULL;
+        }
+    };
+} // ns kadc
+} // ns dht
+
+#endif //DHT_KADC_MPSC_QUEUE_H_
@@ -0,0 +1,131 @@
+#include <ace/Guard_T.h>
+
+#include <new>
+
+#include "object_pool.h"
+#include "atomic.h"
+
+namespace dht {
+namespace kadc {
+
+object_pool::cache::~cache() {
+    // _flush() frees the blocks once the owner is closing
+    if (owner) owner->_flush(this, 0);
+}
+
+object_pool::object_pool(size_t block_size, size_t batch, size_t max_free)
+  : _block_size(block_size < sizeof(block) ? sizeof(block) : block_size),
+    _batch(batch ? batch : 1), _max_free(max_free), 
+    _free(NULL), _nfree(0), _closing(false), 
+    _heap_allocs(0), _heap_frees(0)
+{
+}
+
+object_pool::~object_pool() {
+    // The calling thread's cache is destroyed with _caches after the
+    // shared free list, its blocks would be lost there
+    _flush(_cache(), 0);
+    
+    ACE_Guard<ACE_Thread_Mutex> guard(_m);
+    _closing = true;
+    while (_free) {
+        block *b = _free;
+        _free = b->next;
+        ::operator delete(b);
+    }
+    _nfree = 0;
+}
+
+object_pool::cache *
+object_pool::_cache() {
+    cache *c = _caches;
+    if (c->owner == NULL) c->owner = this;
+    return c;
+}
+
+void
+object_pool::_refill(cache *c) {
+    ACE_Guard<ACE_Thread_Mutex> guard(_m);
+    for (size_t i = 0; i < _batch && _free; i++) {
+        block *b = _free;
+        _free    = b->next;
+        _nfree--;
+        b->next  = c->head;
+        c->head  = b;
+        c->count++;
+    }
+}
+
+void
+object_pool::_flush(cache *c, size_t keep) {
+    ACE_Guard<ACE_Thread_Mutex> guard(_m);
+    while (c->count > keep) {
+        block *b = c->head;
+        c->head  = b->next;
+        c->count--;
+        if (_closing || _nfree >= _max_free) {
+            ::operator delete(b);
+            atomic::add(&_heap_frees, 1UL);
+        } else {
+            b->next = _free;
+            _free   = b;
+            _nfree++;
+        }
+    }
+}
+
+void *
+object_pool::allocate(size_t size) {
+    if (size > _block_size) {
+        atomic::add(&_heap_allocs, 1UL);
+        return ::operator new(size);
+    }
+    
+    cache *c = _cache();
+    if (c->head == NULL) _refill(c);
+    if (c->head == NULL) {
+        atomic::add(&_heap_allocs, 1UL);
+        return ::operator new(_block_size);
+    }
+    
+    block *b = c->head;
+    c->head  = b->next;
+    c->count--;
+    return b;
+}
+
+void
+object_pool::deallocate(void *p, size_t size) {
+    if (p == NULL) return;
+    if (size > _block_size) {
+        atomic::add(&_heap_frees, 1UL);
+        ::operator delete(p);
+        return;
+    }
+    
+    cache *c = _cache();
+    block *b = static_cast<block *>(p);
+    b->next  = c->head;
+    c->head  = b;
+    // Consumer thread's cache would otherwise grow without limit
+    if (++c->count >= 2 * _batch) _flush(c, _batch);
+}
+
+unsigned long
+object_pool::heap_allocations() const {
+    return atomic::load(&_heap_allocs);
+}
+
+unsigned long
+object_pool::heap_frees() const {
+    return atomic::load(&_heap_frees);
+}
+
+size_t
+object_pool::free_blocks() {
+    ACE_Guard<ACE_Thread_Mutex> guard(_m);
+    return _nfree;
+}
+
+} // ns kadc
+} // ns dht
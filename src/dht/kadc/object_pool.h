@@ -0,0 +1,84 @@
+#ifndef DHT_KADC_OBJECT_POOL_H_
+#define DHT_KADC_OBJECT_POOL_H_
+
+#include <ace/Thread_Mutex.h>
+#include <ace/TSS_T.h>
+
+#include <stddef.h>
+
+namespace dht {
+namespace kadc {
+    /**
+     * Freelist allocator for fixed size blocks, meant for objects that 
+     * are allocated in one thread and freed in another (messages 
+     * from KadC threads to the reactor thread).
+     * 
+     * Each thread has its own cache of free blocks, so that most 
+     * allocations and deallocations do not touch shared state. When a 
+     * thread's cache runs out, a batch of blocks is taken from the 
+     * shared free list. When a cache grows too big, or its thread exits, 
+     * blocks are moved back to the shared free list. Only if 
+     * the shared free list is empty is a block allocated from heap.
+     * 
+     * Requests bigger than the block size are passed to the heap.
+     */
+    class object_pool {
+        struct block {
+            block *next;
+        };
+        struct cache {
+            object_pool *owner;
+            block       *head;
+            size_t       count;
+            
+            cache() : owner(NULL), head(NULL), count(0) {}
+            // Returns the blocks to the owner when the thread exits,
+            // or frees them if the owner is being destroyed
+            ~cache();
+        };
+        friend struct cache;
+
+        size_t _block_size;
+        size_t _batch;
+        size_t _max_free;
+
+        ACE_Thread_Mutex _m;
+        block           *_free;
+        size_t           _nfree;
+        // Set by the destructor, blocks flushed after it are freed
+        bool             _closing;
+
+        volatile unsigned long _heap_allocs;
+        volatile unsigned long _heap_frees;
+        
+        // Destroyed after the destructor has freed the shared free
+        // list, so the calling thread's cache is flushed before that
+        ACE_TSS<cache>   _caches;
+
+        cache *_cache();
+        void   _refill(cache *c);
+        void   _flush(cache *c, size_t keep);
+    public:
+        // batch is the number of blocks moved at a time between a thread's
+        // cache and the shared free list, max_free is the number of
+        // blocks after which freed blocks are returned to heap
+        object_pool(size_t block_size, size_t batch = 32, 
+                    size_t max_free = 4096);
+        ~object_pool();
+        
+        void *allocate(size_t size);
+        void  deallocate(void *p, size_t size);
+        
+        inline size_t block_size() const { return _block_size; }
+        // Number of allocations that had to go to heap
+        unsigned long heap_allocations() const;
+        // Number of deallocations that were returned to heap
+        unsigned long heap_frees() const;
+        // Number of blocks in the shared free list
+        size_t free_blocks();
+    };
+    
+} // ns kadc
+} // ns dht
+
+#endif //DHT_KADC_OBJECT_POOL_H_
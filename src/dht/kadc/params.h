@@ -0,0 +1,87 @@
+#ifndef DHT_KADC_PARAMS_H_
+#define DHT_KADC_PARAMS_H_
+
+#include <stddef.h>
+
+#include "../common.h"
+
+namespace dht {
+namespace kadc {
+    /**
+     * Priority classes of operations waiting for a worker of the
+     * task pool. A free worker takes the oldest operation of the
+     * highest class that is below its concurrency limit, see the
+     * task_pool_limit options of client::init().
+     */
+    enum priority_class {
+        // Lookups an application waits for, default of find()
+        prio_interactive = 0,
+        // Default of find_many()
+        prio_normal,
+        // Default of store() and store_many()
+        prio_background,
+        prio_classes
+    };
+
+    /**
+     * @class find_params params.h dht/kadc/params.h
+     * @brief KadC parameters of a single find()
+     *
+     * Fields left 0 are taken from the client's find_threads(),
+     * find_duration() and find_max_hits() when find() is called,
+     * so changing the client's values later does not affect the
+     * search.
+     *
+     * If deadline is set, it is the absolute time
+     * (ACE_OS::gettimeofday()) by which the search must be over.
+     * The search is shortened to end by then and fails without
+     * searching if the deadline has passed before it could start.
+     *
+     * priority is one of priority_class, -1 for the default of
+     * the operation.
+     */
+    struct find_params {
+        size_t          threads;
+        // Seconds
+        size_t          duration;
+        size_t          max_hits;
+        time_value_type deadline;
+        int             priority;
+
+        inline find_params()
+          : threads(0), duration(0), max_hits(0),
+            deadline(time_value_type::zero), priority(-1) {}
+
+        inline bool operator==(const find_params &o) const {
+            return threads  == o.threads  && duration == o.duration &&
+                   max_hits == o.max_hits && deadline == o.deadline &&
+                   priority == o.priority;
+        }
+        inline bool operator!=(const find_params &o) const {
+            return !(*this == o);
+        }
+    };
+
+    /**
+     * @class store_params params.h dht/kadc/params.h
+     * @brief KadC parameters of a single store()
+     *
+     * Like find_params, fields left 0 are taken from the client's
+     * store_threads() and store_duration() when store() is called.
+     */
+    struct store_params {
+        size_t          threads;
+        // Seconds
+        size_t          duration;
+        time_value_type deadline;
+        int             priority;
+
+        inline store_params()
+          : threads(0), duration(0), deadline(time_value_type::zero),
+            priority(-1) {}
+    };
+
+} // ns kadc
+} // ns dht
+
+#endif //DHT_KADC_PARAMS_H_
@@ -1,10 +1,13 @@
 #include "reactor_event_handler.h"
 #include "client.h"
+#include "atomic.h"
 
 namespace dht {
 namespace kadc {
 
-reactor_event_handler::reactor_event_handler(client *owner_client) {
+reactor_event_handler::reactor_event_handler(client *owner_client) 
+  : _pending(0), _wakeups(0), _wakeups_saved(0)
+{
     owner(owner_client);
 }
 
@@ -17,22 +20,54 @@ reactor_event_handler::owner(client *n) {
 
 void
 reactor_event_handler::signal() {
+    // A burst of messages needs only one notification, since
+    // everything in the queue is processed at once
+    if (!atomic::compare_and_swap(&_pending, 0L, 1L)) {
+        atomic::add(&_wakeups_saved, 1UL);
+        return;
+    }
+    
     ACE_DEBUG((LM_DEBUG, 
               "%t reactor_event_handler::signal called, owner: %d\n",
               _owner));
     ACE_DEBUG((LM_DEBUG, 
               "%t reactor_event_handler::signal called, reactor: %d\n",
               _owner->reactor()));
-    _owner->reactor()->notify(this);
+    atomic::add(&_wakeups, 1UL);
+    if (_owner->reactor()->notify(this) == -1) {
+        ACE_ERROR((LM_ERROR, 
+                  "%t reactor_event_handler::signal notify failed\n"));
+        // Let the next signal try again
+        atomic::store(&_pending, 0L);
+    }
+}
+
+unsigned long
+reactor_event_handler::wakeups() const {
+    return atomic::load(&_wakeups);
+}
+
+unsigned long
+reactor_event_handler::wakeups_saved() const {
+    return atomic::load(&_wakeups_saved);
 }
     
 int
 reactor_event_handler::handle_exception(ACE_HANDLE) {
     ACE_DEBUG((LM_DEBUG, "%t reactor_event_handler::handle_exception called\n"));
+    // Cleared before emptying the queue: a message pushed after the 
+    // queue has been passed must send a new notification.
+    atomic::store(&_pending, 0L);
     _owner->_process_queue();
     return 0;
 }
 
+int
+reactor_event_handler::handle_timeout(const ACE_Time_Value &, const void *) {
+    _owner->_flush_batches();
+    return 0;
+}
+
 } // ns kadc
 } // ns dht
 
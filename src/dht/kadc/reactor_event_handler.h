@@ -12,6 +12,10 @@ class client;
 class reactor_event_handler : public ACE_Event_Handler {
     class client *_owner;
     
+    // 1 while a notification is on its way to the reactor
+    volatile long          _pending;
+    volatile unsigned long _wakeups;
+    volatile unsigned long _wakeups_saved;
 public:
     reactor_event_handler(class client *owner_client);
     virtual ~reactor_event_handler();
@@ -20,10 +24,19 @@ public:
     
     // Called when the client's message queue might have something in it.
     // Wakes up the reactor so that this class will be called again from
-    // the reactor thread.
+    // the reactor thread. Can be called from any thread. If the reactor 
+    // has already been notified but has not yet started emptying the 
+    // queue, no new notification is sent.
     void signal();
     
+    // Number of notifications sent to the reactor
+    unsigned long wakeups() const;
+    // Number of signal() calls that did not need a notification
+    unsigned long wakeups_saved() const;
+    
     virtual int handle_exception(ACE_HANDLE);
+    // Batch window timer of the client
+    virtual int handle_timeout(const ACE_Time_Value &now, const void *act);
 };
 
 } // ns kadc
@@ -0,0 +1,135 @@
+#include <ace/Guard_T.h>
+#include <ace/OS_NS_sys_time.h>
+
+#include "result_cache.h"
+
+using namespace std;
+
+namespace dht {
+namespace kadc {
+
+result_cache::result_cache(size_t max_entries, size_t max_bytes,
+                           const time_value_type &ttl)
+  : _max_entries(max_entries), _max_bytes(max_bytes), _bytes(0), _ttl(ttl),
+    _hits(0), _misses(0), _evictions(0)
+{
+}
+
+result_cache::~result_cache() {}
+
+size_t
+result_cache::_entry_bytes(const values_type &values) {
+    // Estimate: the index is stored twice (map and LRU list)
+    size_t b = sizeof(entry) + 2 * sizeof(key128) + 
+               values.size() * sizeof(value);
+    values_type::const_iterator i = values.begin();
+    for (; i != values.end(); i++) {
+        b += i->size();
+        name_value_map::const_iterator m = i->meta().begin();
+        for (; m != i->meta().end(); m++)
+            b += m->first.size() + m->second.size();
+    }
+    return b;
+}
+
+void
+result_cache::_erase(entries_type::iterator i) {
+    _bytes -= i->second.bytes;
+    _lru.erase(i->second.lru);
+    _entries.erase(i);
+}
+
+bool
+result_cache::get(const key128 &index, values_type *result) {
+    ACE_Guard<ACE_Thread_Mutex> guard(_m);
+    entries_type::iterator i = _entries.find(index);
+    if (i == _entries.end()) {
+        _misses++;
+        return false;
+    }
+    if (i->second.expires < ACE_OS::gettimeofday()) {
+        _erase(i);
+        _misses++;
+        return false;
+    }
+    
+    _lru.splice(_lru.begin(), _lru, i->second.lru);
+    *result = i->second.values;
+    _hits++;
+    return true;
+}
+
+void
+result_cache::put(const key128 &index, values_type *values) {
+    size_t b = _entry_bytes(*values);
+    ACE_Guard<ACE_Thread_Mutex> guard(_m);
+    
+    entries_type::iterator i = _entries.find(index);
+    if (i != _entries.end()) _erase(i);
+    // An entry that alone exceeds the memory cap is not cached
+    if (_max_bytes && b > _max_bytes) return;
+    
+    while (!_lru.empty() &&
+           ((_max_entries && _entries.size() >= _max_entries) ||
+            (_max_bytes   && _bytes + b > _max_bytes)))
+    {
+        _erase(_entries.find(_lru.back()));
+        _evictions++;
+    }
+    
+    _lru.push_front(index);
+    entry &e  = _entries[index];
+    e.values.swap(*values);
+    e.expires = ACE_OS::gettimeofday() + _ttl;
+    e.bytes   = b;
+    e.lru     = _lru.begin();
+    _bytes   += b;
+}
+
+void
+result_cache::erase(const key128 &index) {
+    ACE_Guard<ACE_Thread_Mutex> guard(_m);
+    entries_type::iterator i = _entries.find(index);
+    if (i != _entries.end()) _erase(i);
+}
+
+void
+result_cache::clear() {
+    ACE_Guard<ACE_Thread_Mutex> guard(_m);
+    _entries.clear();
+    _lru.clear();
+    _bytes = 0;
+}
+
+size_t
+result_cache::entries() const {
+    ACE_Guard<ACE_Thread_Mutex> guard(_m);
+    return _entries.size();
+}
+
+size_t
+result_cache::bytes() const {
+    ACE_Guard<ACE_Thread_Mutex> guard(_m);
+    return _bytes;
+}
+
+unsigned long
+result_cache::hits() const {
+    ACE_Guard<ACE_Thread_Mutex> guard(_m);
+    return _hits;
+}
+
+unsigned long
+result_cache::misses() const {
+    ACE_Guard<ACE_Thread_Mutex> guard(_m);
+    return _misses;
+}
+
+unsigned long
+result_cache::evictions() const {
+    ACE_Guard<ACE_Thread_Mutex> guard(_m);
+    return _evictions;
+}
+
+} // ns kadc
+} // ns dht
@@ -0,0 +1,81 @@
+#ifndef DHT_KADC_RESULT_CACHE_H_
+#define DHT_KADC_RESULT_CACHE_H_
+
+#include <ace/Thread_Mutex.h>
+
+#include <list>
+#include <map>
+#include <vector>
+
+#include "../common.h"
+#include "../value.h"
+#include "key128.h"
+
+namespace dht {
+namespace kadc {
+    /**
+     * Bounded LRU cache of search results keyed by the KadC index
+     * (128-bit hash) of the search key. Entries 
+     * expire after a time to live, and least recently used entries
+     * are evicted when the number of entries or the memory used by 
+     * them would exceed the limits.
+     * 
+     * Filled by task_find threads and read by the reactor thread, 
+     * so all functions are thread safe.
+     */
+    class result_cache {
+    public:
+        typedef std::vector<value> values_type;
+    private:
+        // Most recently used index first
+        typedef std::list<key128> lru_type;
+        struct entry {
+            values_type        values;
+            time_value_type    expires;
+            size_t             bytes;
+            lru_type::iterator lru;
+        };
+        typedef std::map<key128, entry> entries_type;
+        
+        entries_type     _entries;
+        lru_type         _lru;
+        size_t           _max_entries;
+        size_t           _max_bytes;
+        size_t           _bytes;
+        time_value_type  _ttl;
+        
+        unsigned long    _hits;
+        unsigned long    _misses;
+        unsigned long    _evictions;
+        
+        mutable ACE_Thread_Mutex _m;
+        
+        static size_t _entry_bytes(const values_type &values);
+        void _erase(entries_type::iterator i);
+    public:
+        // Limit of 0 means unlimited
+        result_cache(size_t max_entries, size_t max_bytes,
+                     const time_value_type &ttl);
+        ~result_cache();
+        
+        // Copies the cached values of the index to result if there
+        // is an entry that has not expired. Counts a hit or a miss.
+        bool get(const key128 &index, values_type *result);
+        // Adds or replaces the entry of the index. Takes the values
+        // by swapping them with the given vector.
+        void put(const key128 &index, values_type *values);
+        // Removes the entry of the index, for example when a new value
+        // has been stored with it
+        void erase(const key128 &index);
+        void clear();
+        
+        size_t        entries()   const;
+        size_t        bytes()     const;
+        unsigned long hits()      const;
+        unsigned long misses()    const;
+        unsigned long evictions() const;
+    };
+} // ns kadc
+} // ns dht
+
+#endif //DHT_KADC_RESULT_CACHE_H_
@@ -3,6 +3,11 @@
 #include "client.h"
 #include "message.h"
 #include "message_search.h"
+#include "message_search_batch.h"
+#include "message_search_view.h"
+#include "message_store.h"
+#include "message_search_many.h"
+#include "task_find_many.h"
 
 namespace dht {
 namespace kadc {
@@ -13,22 +18,53 @@ state::~state() {}
 
 void 
 state::store(client *d,
-               const key      &index,
-               const value    &content,
-               notify_handler *notify)
+             const key          &index,
+             const value        &content,
+             notify_handler     *notify,
+             const store_params &params)
 {
     throw call_errorf("dht::kadc::store not connected, current state '%s'",
                      id());         
 }
 
+void
+state::find_many(client *d,
+                 const key      *begin,
+                 const key      *end,
+                 search_handler *handler)
+{
+    throw call_errorf("dht::kadc::find_many not connected, current state '%s'",
+                     id());
+}
+
+void 
+state::store_many(client *d,
+                  const client::key_value *begin,
+                  const client::key_value *end,
+                  notify_handler          *notify)
+{
+    throw call_errorf("dht::kadc::store_many not connected, current state '%s'",
+                     id());         
+}
+
 void
 state::find(client *d,
-            const key      &index,
-            search_handler *handler)
+            const key         &index,
+            search_handler    *handler,
+            const find_params &params)
 {
     throw call_errorf("dht::kadc::find not connected, current state '%s'",
                      id());
 }
+
+void
+state::find_move(client *d,
+                 key               *index,
+                 search_handler    *handler,
+                 const find_params &params)
+{
+    find(d, *index, handler, params);
+}
           
 
 void
@@ -44,6 +80,30 @@ state::notify(client *d, const message *m, notify_handler *n) {
     }
 }
 
+void
+state::store_item(client *d, const message *m, notify_handler *h) {
+    const message_store *ms = dynamic_cast<const message_store *>(m);
+    store_many_handler  *sh = dynamic_cast<store_many_handler *>(h);
+    
+    if (m && !ms) throw unexpected_errorf(
+                   "store_item:COULD NOT CAST TO STORE MESSAGE %p",
+                   m);
+    if (h && !sh) throw unexpected_errorf(
+                   "store_item:COULD NOT CAST TO STORE MANY HANDLER %p",
+                   h);
+    if (sh) {
+        if (ms->success()) {
+            ACE_DEBUG((LM_DEBUG, "kadc::notifying handler of stored item\n"));
+            sh->stored(*(ms->store_key()), *(ms->store_value()), 
+                       ms->replicas());
+        } else {
+            ACE_DEBUG((LM_DEBUG, "kadc::notifying handler of failed item\n"));
+            sh->store_failed(*(ms->store_key()), *(ms->store_value()), 
+                             m->code(), m->string());
+        }
+    }
+}
+
 int
 state::search_result(client *d, const message *m, notify_handler *h) {
     const message_search *ms = dynamic_cast<const message_search *>(m);
@@ -58,13 +118,60 @@ state::search_result(client *d, const message *m, notify_handler *h) {
     const key   &k = *(ms->search_key());
     const value &v = *(ms->result_value());
     
-    int ret = this->observer_notifier(d)->search_result(k, v);
+    // Event observers are notified by the client once per message,
+    // not once per handler of the search
     if (sh) {
-        // The value returned by explicitly set handler always overrides
-        // one returned by observer.        
         ACE_DEBUG((LM_DEBUG, "kadc::notifying search handler of result\n"));
-        return sh->found(*(ms->search_key()), *(ms->result_value()));
+        return sh->found(k, v);
     }
+    return 0;
+}
+
+int
+state::search_batch(client *d, const message *m, notify_handler *h) {
+    const message_search_batch *mb = 
+        dynamic_cast<const message_search_batch *>(m);
+    search_handler             *sh = dynamic_cast<search_handler *>(h);
+    
+    if (m && !mb) throw unexpected_errorf(
+                   "search_batch:COULD NOT CAST TO SEARCH BATCH MESSAGE %p",
+                   m);
+    if (h && !sh) throw unexpected_errorf(
+                   "search_batch:COULD NOT CAST TO SEARCH HANDLER %p",
+                   h);
+    const key                               &k  = *(mb->search_key());
+    const message_search_batch::values_type &vs = mb->result_values();
+    if (vs.empty()) return 0;
+    
+    const value *begin = &vs[0];
+    const value *end   = begin + vs.size();
+    
+    if (sh) {
+        ACE_DEBUG((LM_DEBUG, "kadc::notifying search handler of %d results\n",
+                  vs.size()));
+        return sh->found_batch(k, begin, end);
+    }
+    return 0;
+}
+
+int
+state::search_view(client *d, const message *m, notify_handler *h) {
+    const message_search_view *mv = 
+        dynamic_cast<const message_search_view *>(m);
+    search_handler            *sh = dynamic_cast<search_handler *>(h);
+    
+    if (m && !mv) throw unexpected_errorf(
+                   "search_view:COULD NOT CAST TO SEARCH VIEW MESSAGE %p",
+                   m);
+    if (h && !sh) throw unexpected_errorf(
+                   "search_view:COULD NOT CAST TO SEARCH HANDLER %p",
+                   h);
+    const key &k = *(mv->search_key());
+    
+    if (!sh) return 0;
+    int ret = 0;
+    for (size_t i = 0; i < mv->records() && !ret; i++)
+        ret = sh->found_view(k, mv->record(i));
     return ret;
 }
 
@@ -90,5 +197,48 @@ state::search_done(client *d, const message *m, notify_handler *h) {
     }
 }
 
+void
+state::search_many_result(client *d, const message *m, notify_handler *h) {
+    const message_search_many *ms = 
+        dynamic_cast<const message_search_many *>(m);
+    task_find_many            *t  = 
+        dynamic_cast<task_find_many *>(m->from_task());
+    
+    if (!ms || !t) throw unexpected_errorf(
+                   "search_many_result:COULD NOT CAST TO SEARCH MANY " \
+                   "MESSAGE OR TASK %p", m);
+    // Handler did not want more results of this key
+    if (t->stopped(ms->item())) return;
+    if (this->search_result(d, m, h)) t->stop(ms->item());
+}
+
+void
+state::search_key_done(client *d, const message *m, notify_handler *h) {
+    const message_search_many *ms = 
+        dynamic_cast<const message_search_many *>(m);
+    task_find_many            *t  = 
+        dynamic_cast<task_find_many *>(m->from_task());
+    
+    if (!ms || !t) throw unexpected_errorf(
+                   "search_key_done:COULD NOT CAST TO SEARCH MANY " \
+                   "MESSAGE OR TASK %p", m);
+    // Like with find(), success/failure is not called for a search
+    // whose results the handler stopped
+    if (t->stopped(ms->item())) return;
+    this->search_done(d, m, h);
+}
+
+void
+state::search_many_done(client *d, const message *m, notify_handler *h) {
+    search_handler *sh = dynamic_cast<search_handler *>(h);
+    if (h && !sh) throw unexpected_errorf(
+                   "search_many_done:COULD NOT CAST TO SEARCH HANDLER %p",
+                   h);
+    if (sh) {
+        ACE_DEBUG((LM_DEBUG, "kadc::notifying search handler of finish\n"));
+        sh->finished();
+    }
+}
+
 } // ns kadc
 } // ns dht
@@ -31,6 +31,18 @@ namespace kadc {
         void task_add(client *d, task *t) {
             d->_task_add(t);
         }
+        void task_submit(client *d, task *t) {
+            d->_task_submit(t);
+        }
+        void task_run(client *d, task *t) {
+            d->_task_run(t);
+        }
+        task *running_find(client *d, const key128 &index) {
+            return d->_running_find(index);
+        }
+        void running_find_add(client *d, const key128 &index, task *t) {
+            d->_running_find_add(index, t);
+        }
         void quit_all_tasks(client *d) {
             d->_quit_all_tasks();
         }
@@ -57,8 +69,17 @@ namespace kadc {
         }
                 
         void notify(client *d, const class message *m, notify_handler *n);
+        void store_item(client *d, const class message *m, notify_handler *n);
         int  search_result(client *d, const class message *m, notify_handler *n);
+        int  search_batch(client *d, const class message *m, notify_handler *n);
+        int  search_view(client *d, const class message *m, notify_handler *n);
         void search_done(client *d, const class message *m, notify_handler *n);
+        void search_many_result(client *d, const class message *m, 
+                                notify_handler *n);
+        void search_key_done(client *d, const class message *m, 
+                             notify_handler *n);
+        void search_many_done(client *d, const class message *m, 
+                              notify_handler *n);
         
         state(const char *id = "");
         virtual ~state();
@@ -66,14 +87,32 @@ namespace kadc {
         virtual void connect(client *d, notify_handler *n) = 0;
         virtual void disconnect(client *d, notify_handler *n) = 0;
 
+        // params have the client's defaults filled in
         virtual void find(client *d,
-                          const key      &index,
-                          search_handler *handler);
+                          const key         &index,
+                          search_handler    *handler,
+                          const find_params &params);
+        // Like find(), takes the key by swapping. By default calls find().
+        virtual void find_move(client *d,
+                               key               *index,
+                               search_handler    *handler,
+                               const find_params &params);
+        
+        virtual void find_many(client *d,
+                               const key      *begin,
+                               const key      *end,
+                               search_handler *handler);
         
         virtual void store(client *d,
-                           const key      &index,
-                           const value    &content,
-                           notify_handler *notify = NULL);
+                           const key          &index,
+                           const value        &content,
+                           notify_handler     *notify,
+                           const store_params &params);
+        
+        virtual void store_many(client *d,
+                                const client::key_value *begin,
+                                const client::key_value *end,
+                                notify_handler          *notify = NULL);
         
         inline const char *id() const { return _id; }
     };
@@ -4,7 +4,10 @@
 #include "state_connected.h"
 #include "state_disconnecting.h"
 #include "task_store.h"
+#include "task_store_many.h"
 #include "task_find.h"
+#include "task_find_cached.h"
+#include "task_find_many.h"
 #include "client.h"
 
 using namespace std;
@@ -33,33 +36,119 @@ state_connected::disconnect(client *d, notify_handler *n) {
 
 void 
 state_connected::store(client *d,
-                       const key      &index,
-                       const value    &content,
-                       notify_handler *n)
+                       const key          &index,
+                       const value        &content,
+                       notify_handler     *n,
+                       const store_params &params)
 {
     // Start task that handles storeing
     KadCcontext              *kccptr = this->kad_context(d);
     client::message_queue_type *msg_q  = this->message_queue(d);
-    task *t = new task_store(d, msg_q, kccptr, index, content, n);  
-    this->task_add(d, t);
-    if (n) this->attach_observer_messages(d, observer_info(this, n, t));
+    auto_ptr<task> t(new task_store(d, msg_q, kccptr, index, content, n,
+                                    params));
+    // Owned by the client after successfully submitted
+    this->task_submit(d, t.get());
+    task *tp = t.release();
+    if (n) this->attach_observer_messages(d, observer_info(this, n, tp));
+}
+
+void 
+state_connected::store_many(client *d,
+                            const client::key_value *begin,
+                            const client::key_value *end,
+                            notify_handler          *n)
+{
+    // One task stores every pair
+    KadCcontext                *kccptr = this->kad_context(d);
+    client::message_queue_type *msg_q  = this->message_queue(d);
+    auto_ptr<task> t(new task_store_many(d, msg_q, kccptr, begin, end, n));
+    // Owned by the client after successfully submitted
+    this->task_submit(d, t.get());
+    task *tp = t.release();
+    if (n) this->attach_observer_messages(d, observer_info(this, n, tp));
 }
 
 void 
 state_connected::find(client *d,
-                      const key      &index,
-                      search_handler *handler)
+                      const key         &index,
+                      search_handler    *handler,
+                      const find_params &params)
+{
+    // The task keeps a copy of the key
+    key k(index);
+    find_move(d, &k, handler, params);
+}
+
+void 
+state_connected::find_move(client *d,
+                           key               *index,
+                           search_handler    *handler,
+                           const find_params &params)
 {
     // Start task that handles searching
     KadCcontext              *kccptr = this->kad_context(d);
     client::message_queue_type *msg_q  = this->message_queue(d);
-    task *t = new task_find(d, msg_q, kccptr, index, handler);
-    this->task_add(d, t);
-    if (handler) 
-        this->attach_observer_messages(d, observer_info(this, handler, t));
     
+    key128 kindex;
+    task_find::make_index(&kindex, *index);
+    
+    // Cached results are delivered without searching
+    result_cache             *cache = d->find_cache();
+    result_cache::values_type values;
+    if (cache && cache->get(kindex, &values)) {
+        auto_ptr<task> t(new task_find_cached(d, msg_q, index, 
+                                              &values, handler));
+        task *tp = t.get();
+        if (handler) 
+            this->attach_observer_messages(d, observer_info(this, handler, tp));
+        this->task_run(d, t.release());
+        return;
+    }
+    
+    // Only searches with the client's parameters are shared, so that
+    // a quick lookup and a thorough search do not cut short or 
+    // prolong each other
+    find_params defaults;
+    d->find_defaults(&defaults);
+    bool shared = (params == defaults);
+    
+    // Running search of the same key delivers its results from now on
+    // also to this handler
+    task *running = shared ? this->running_find(d, kindex) : NULL;
+    if (running) {
+        if (handler) this->attach_observer_messages(
+                         d, observer_info(this, handler, running));
+        return;
+    }
+    
+    auto_ptr<task> t(new task_find(d, msg_q, kccptr, index, handler, 
+                                   params));
+    // Owned by the client after successfully submitted
+    this->task_submit(d, t.get());
+    task *tp = t.release();
+    if (shared) this->running_find_add(d, kindex, tp);
+    if (handler) 
+        this->attach_observer_messages(d, observer_info(this, handler, tp));
 }                      
 
+void 
+state_connected::find_many(client *d,
+                           const key      *begin,
+                           const key      *end,
+                           search_handler *handler)
+{
+    // One task searches every key
+    KadCcontext                *kccptr = this->kad_context(d);
+    client::message_queue_type *msg_q  = this->message_queue(d);
+    auto_ptr<task> t(new task_find_many(d, msg_q, kccptr, begin, end, 
+                                        handler));
+    // Owned by the client after successfully submitted
+    this->task_submit(d, t.get());
+    task *tp = t.release();
+    if (handler) 
+        this->attach_observer_messages(d, observer_info(this, handler, tp));
+}
+
 int
 state_connected::received_message(client *d, message *m, const observer_info &oi) {
     switch (m->type()) {
@@ -68,10 +157,33 @@ state_connected::received_message(client *d, message *m, const observer_info &oi
         this->notify(d, m, oi.handler());
             // Remove this observer
         return 1;
+    case client::msg_store_item:
+        // Received when storing one pair of store_many finished
+        this->store_item(d, m, oi.handler());
+        return 0;
     case client::msg_search_result:
         // Received when one result for a search is obtained
         // The handler might request no more results to be delivered
         return this->search_result(d, m, oi.handler());
+    case client::msg_search_batch:
+        // Received when several results for a search are obtained
+        return this->search_batch(d, m, oi.handler());
+    case client::msg_search_view:
+        // Received when results for a search are delivered as views
+        return this->search_view(d, m, oi.handler());
+    case client::msg_search_many_result:
+        // Received when one result for a key of find_many is obtained
+        this->search_many_result(d, m, oi.handler());
+        return 0;
+    case client::msg_search_key_done:
+        // Received when search of a key of find_many is finished
+        this->search_key_done(d, m, oi.handler());
+        return 0;
+    case client::msg_search_many_done:
+        // Received when every key of find_many is finished
+        this->search_many_done(d, m, oi.handler());
+        // Remove this observer
+        return 1;
     case client::msg_search_done:
         // Received when search is finished
         this->search_done(d, m, oi.handler());
@@ -15,12 +15,26 @@ namespace kadc {
         virtual void connect(client *d, notify_handler *n);
         virtual void disconnect(client *d, notify_handler *n);
         virtual void find(client *d,
-                          const key      &index,
-                          search_handler *handler);     
+                          const key         &index,
+                          search_handler    *handler,
+                          const find_params &params);     
+        virtual void find_move(client *d,
+                               key               *index,
+                               search_handler    *handler,
+                               const find_params &params);
+        virtual void find_many(client *d,
+                               const key      *begin,
+                               const key      *end,
+                               search_handler *handler);
         virtual void store(client *d,
-                           const key      &index,
-                           const value    &content,
-                           notify_handler *notify = NULL);
+                           const key          &index,
+                           const value        &content,
+                           notify_handler     *notify,
+                           const store_params &params);
+        virtual void store_many(client *d,
+                                const client::key_value *begin,
+                                const client::key_value *end,
+                                notify_handler          *notify = NULL);
 
         // Observer interface
         virtual int received_message(client *d, message *m, 
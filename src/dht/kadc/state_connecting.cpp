@@ -1,11 +1,14 @@
 #include <memory>
 
+#include <ace/OS_NS_unistd.h>
+
 #include "../exception.h"
 #include "state_connecting.h"
 #include "state_connected.h"
 #include "state_disconnected.h"
 #include "state_disconnecting.h"
 #include "task_connected_detect.h"
+#include "task_snapshot.h"
 #include "client.h"
 #include "util.h"
 
@@ -44,7 +47,22 @@ state_connecting::prepare_connecting(client *d, notify_handler *n) {
     int passive_mode = 1;
     const char *init_file = d->init_file();
     KadCcontext *kcc = this->kad_context(d);
-    *kcc = KadC_start((char *)init_file, passive_mode, 0);
+    
+    // Contacts of the last session are likely to still respond, so 
+    // the snapshot gets connected faster than the full contact list
+    const string &snapshot = d->snapshot_file();
+    if (d->snapshot_interval() != time_value_type::zero &&
+        ACE_OS::access(snapshot.c_str(), R_OK) == 0) 
+    {
+        ACE_DEBUG((LM_DEBUG, "kadc::prepare_connecting using snapshot %s\n",
+                   snapshot.c_str()));
+        *kcc = KadC_start((char *)snapshot.c_str(), passive_mode, 0);
+        if (kcc->s == KADC_OK) init_file = snapshot.c_str();
+        else ACE_DEBUG((LM_DEBUG, "kadc::prepare_connecting KadC_start "
+                        "with snapshot failed, using %s\n", init_file));
+    }
+    if (init_file != snapshot.c_str())
+        *kcc = KadC_start((char *)init_file, passive_mode, 0);
     this->kadc_started(d, true);
     
     if(kcc->s != KADC_OK) {
@@ -58,7 +76,7 @@ state_connecting::prepare_connecting(client *d, notify_handler *n) {
     // the next state.
     client::message_queue_type *msg_queue = this->message_queue(d);
     
-    this->task_add(d, new task_connected_detect(msg_queue, kcc));
+    this->task_add(d, new task_connected_detect(d, msg_queue, kcc));
     this->attach_observer_messages(d, observer_info(this, n));
 }
 
@@ -73,6 +91,11 @@ state_connecting::received_message(client *d, message *m,
         util::kadc_external_address(&ext, this->kad_context(d));
         this->external_addr(d, ext);
         this->change_state(d, state_connected::instance(), client::connected);
+        
+        if (d->snapshot_interval() != time_value_type::zero) {
+            this->task_add(d, new task_snapshot(d, this->message_queue(d),
+                                                this->kad_context(d)));
+        }
     } else {
         this->change_state(d, state_disconnected::instance(), 
                            client::disconnected);
@@ -1,15 +1,21 @@
+#include <ace/Guard_T.h>
+
 #include "task.h"
 
 namespace dht {
 namespace kadc {
 
-task::task(const char *id) : _quit(false), _id(id) {
-    _cond = new cond_type(_m);
-    
+task::task(const char *id) 
+  : _quit(false), _id(id), _pooled(false), _priority(prio_normal), 
+    _done(false) 
+{
+    _cond      = new cond_type(_m);
+    _done_cond = new cond_type(_done_m);
 }
     
 task::~task() {
     delete _cond;   
+    delete _done_cond;
 }
     
 int 
@@ -34,5 +40,27 @@ task::quit() {
     return ret;
 }
 
+int
+task::run() {
+    int ret = this->svc();
+    
+    ACE_Guard<ACE_Thread_Mutex> guard(_done_m);
+    _done = true;
+    _done_cond->broadcast();
+    
+    return ret;
+}
+
+int
+task::join() {
+    // Task running in its own thread
+    if (!_pooled) return ACE_Task_Base::wait();
+    
+    // Task running in a pool's worker thread
+    ACE_Guard<ACE_Thread_Mutex> guard(_done_m);
+    while (!_done) _done_cond->wait();
+    return 0;
+}
+
 } // ns kadc
 } // ns dht
@@ -5,6 +5,8 @@
 #include <ace/Recursive_Thread_Mutex.h>
 #include <ace/Task.h>
 
+#include "params.h"
+
 namespace dht {
 namespace kadc {
     using namespace std;
@@ -15,6 +17,14 @@ namespace kadc {
         typedef ACE_Condition<ACE_Thread_Mutex> cond_type;
         cond_type *_cond;
         const char *_id;
+
+        // Completion state for tasks that are run by task_pool instead
+        // of their own thread
+        bool             _pooled;
+        int              _priority;
+        bool             _done;
+        ACE_Thread_Mutex _done_m;
+        cond_type       *_done_cond;
     public:
         task(const char *id = "");
         virtual ~task();
@@ -24,8 +34,17 @@ namespace kadc {
         int wait(const ACE_Time_Value &timeout);
         void quit(bool val);
         bool quit();
+
+        // Runs svc() in the calling thread and marks the task done.
+        // Used by task_pool workers.
+        int run();
+        inline void pooled(bool p)   { _pooled = p; }
+        inline bool pooled() const   { return _pooled; }
+        // priority_class the task waits in the task_pool with
+        inline void priority(int p)  { _priority = p; }
+        inline int  priority() const { return _priority; }
         
-        inline int join() { return ACE_Task_Base::wait(); }
+        int join();
         inline const char *id() { return _id; }
     };
     
@@ -11,19 +11,23 @@ namespace dht {
 namespace kadc {
 
 task_connected_detect::task_connected_detect(
+    client                  *n,
     client::message_queue_type *q,
     KadCcontext             *kcc) : task("connected_detect")
 {
     _msg_queue = q;
     _kcc       = kcc;
     
-    // 0.5 second poll interval
-    // 2m00s connection timeout
+    // Defaults are 50 ms to 0.5 second poll interval,
+    // 2m00s connection timeout and
     // 0m30s client timeout, which is started when first node is
     //       contacted
-    _poll_interval = time_value_type(0,  5 * 100000);
-    _conn_timeout  = time_value_type(120);
-    _node_timeout  = time_value_type(30);
+    _poll_min      = n->connect_poll_min();
+    _poll_max      = n->connect_poll_max();
+    _poll_interval = _poll_min;
+    _conn_timeout  = n->connect_timeout();
+    _node_timeout  = n->node_timeout();
+    _connect_nodes = (int)n->connect_nodes();
     
     _info_debug_interval = time_value_type(10);
 }
@@ -74,18 +78,22 @@ task_connected_detect::svc(void) {
                       "(%d)\n", fwstatus));
             last_fwstatus = fwstatus;
         }
+        // KadC does not notify of new nodes, so it is polled. Poll 
+        // often while nodes are being found and back off when not.
         if (nknodes != last_nknodes) {
             ACE_DEBUG((LM_DEBUG, "task_connected_detect: nodes/contacts %d/%d\n",
                        nknodes, ncontact));
-            last_nknodes = nknodes;
+            last_nknodes   = nknodes;
+            _poll_interval = _poll_min;
+        } else {
+            _poll_interval = _poll_interval + _poll_interval;
+            if (_poll_max < _poll_interval) _poll_interval = _poll_max;
         }
         
-        // TODO configurable? Timeout for connect? Timeout if nodes don't
-        // grow beyond this limit?
-        // Make this reasonably big so that usually KadC library gets
+        // The default is reasonably big so that usually KadC library gets
         // at least node timeout amount of time to get ready for 
         // finds/stores.
-        if (nknodes >= 20) {
+        if (nknodes >= _connect_nodes) {
             ACE_DEBUG((LM_DEBUG, "task_connected_detect: connection detected\n"));
             
             msg_c->success(true);           
@@ -104,11 +112,9 @@ task_connected_detect::svc(void) {
     
     ACE_DEBUG((LM_DEBUG, "task_connected_detect: sending messages\n"));
     
-    ACE_Guard<client::message_queue_type> guard_queue(*_msg_queue); 
-    _msg_queue->push(msg_c.get()); msg_c.release();
-    _msg_queue->push(msg_e.get()); msg_e.release();
+    _msg_queue->push(msg_c.release());
+    _msg_queue->push(msg_e.release());
     _msg_queue->signal();
-    guard_queue.release();
 
     ACE_DEBUG((LM_DEBUG, "task_connected_detect: exiting thread\n"));
     
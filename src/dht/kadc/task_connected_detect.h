@@ -10,6 +10,9 @@ namespace kadc {
         client::message_queue_type *_msg_queue;
         KadCcontext              *_kcc;
         time_value_type           _poll_interval;
+        time_value_type           _poll_min;
+        time_value_type           _poll_max;
+        int                       _connect_nodes;
         time_value_type           _conn_timeout;
         time_value_type           _node_timeout;
         time_value_type           _abs_conn_timeout;
@@ -20,7 +23,8 @@ namespace kadc {
         
         bool _has_timeouted(message *msg_c, int fwstatus, int nkclients);
     public:
-        task_connected_detect(client::message_queue_type *q,
+        task_connected_detect(client                  *n,
+                              client::message_queue_type *q,
                               KadCcontext             *kcc);
         virtual ~task_connected_detect();
         
@@ -44,11 +44,9 @@ task_disconnect::svc(void) {
     
     ACE_DEBUG((LM_DEBUG, "task_disconnect: sending messages\n"));
     
-    ACE_Guard<client::message_queue_type> guard_queue(*_msg_queue); 
-    _msg_queue->push(msg_d.get()); msg_d.release();
-    _msg_queue->push(msg_e.get()); msg_e.release();
+    _msg_queue->push(msg_d.release());
+    _msg_queue->push(msg_e.release());
     _msg_queue->signal();
-    guard_queue.release();
 
     ACE_DEBUG((LM_DEBUG, "task_disconnect: exiting thread!\n"));
     
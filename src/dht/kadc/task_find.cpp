@@ -5,6 +5,8 @@
 #include "../exception.h"
 #include "task_find.h"
 #include "message_search.h"
+#include "message_search_batch.h"
+#include "message_search_view.h"
 #include "client.h"
 #include "util.h"
 
@@ -16,9 +18,37 @@ namespace kadc {
 task_find::task_find(client *n,
                      client::message_queue_type *q,
                      KadCcontext             *kcc,
-                     const key               &skey,
-                     search_handler          *h) : task("search")
+                     key                     *skey,
+                     search_handler          *h,
+                     const find_params       &params) : task("search")
 {
+    make_index(&_index, *skey);
+    
+    _client      = n;
+    _skey.swap(*skey);
+    _msg_queue = q;
+    _kcc       = kcc;
+    _handler   = h;
+    _params    = params;
+    _admission = n->kadc_admission();
+    priority(params.priority);
+    
+    _batch        = NULL;
+    _view_batch   = NULL;
+    _view         = n->find_view();
+    _batch_size   = n->find_batch_size();
+    _batch_window = n->find_batch_window();
+    
+    _cache = n->find_cache();
+}
+
+task_find::~task_find() {
+    delete _batch;
+    delete _view_batch;
+}
+
+void
+task_find::make_index(key128 *index, const key &skey) {
     if (!skey.allow_hash_transform() && skey.size() > 16)
         throw call_errorf(
             "dht::kadc::search too big a key given " \
@@ -27,42 +57,153 @@ task_find::task_find(client *n,
             skey.size()
         );
     
-    util::kadc_hash(&_index, skey.data(), skey.size(), 
-                    skey.allow_hash_transform());
+    util::kadc_hash(index, skey);
+}
+
+void
+task_find::_batch_add(KadCdictionary *d) {
+    time_value_type now = ACE_OS::gettimeofday();
     
-    _client      = n;
-    _skey      = skey;
-    _msg_queue = q;
-    _kcc       = kcc;
-    _handler   = h;
+    // Only hit callbacks of this search contend for the lock
+    ACE_Guard<ACE_Thread_Mutex> guard(_batch_m);
+    if (_batch == NULL) {
+        _batch = new message_search_batch(this, client::msg_search_batch,
+                                          _batch_size);
+        _batch->success(true);
+        _batch->handler(_handler);
+        _batch->search_key(&_skey);
+        _batch_started = now;
+    }
+
+    message_search_batch::values_type &vs = _batch->result_values();
+    vs.push_back(value());
+    util::kadc_result(&vs.back(), d);
+    if (_cache) _cache_values.push_back(vs.back());
+    
+    if (vs.size() < _batch_size && now - _batch_started < _batch_window)
+        return;
+    
+    message *msg_b = _batch;
+    _batch = NULL;
+    guard.release();
+    
+    _msg_queue->push(msg_b);
+    _msg_queue->signal();
 }
 
-task_find::~task_find() {
+void
+task_find::_view_add(KadCdictionary *d) {
+    time_value_type now = ACE_OS::gettimeofday();
+    
+    ACE_Guard<ACE_Thread_Mutex> guard(_batch_m);
+    if (_view_batch == NULL) {
+        _view_batch = new message_search_view(this, client::msg_search_view,
+                                              _batch_size);
+        _view_batch->success(true);
+        _view_batch->handler(_handler);
+        _view_batch->search_key(&_skey);
+        _batch_started = now;
+    }
+    
+    std::string *raw   = _view_batch->record_begin();
+    size_t       start = raw->size();
+    util::kadc_result_raw(raw, d);
+    size_t n = _view_batch->records();
+    if (_cache) {
+        _cache_offsets.push_back(_cache_raw.size());
+        _cache_raw.append(*raw, start, std::string::npos);
+    }
+    
+    // Batched like values, a batch size of 1 delivers each result
+    if (n < _batch_size && now - _batch_started < _batch_window)
+        return;
+    
+    message *msg_v = _view_batch;
+    _view_batch = NULL;
+    guard.release();
+    
+    _msg_queue->push(msg_v);
+    _msg_queue->signal();
+}
+
+void
+task_find::_batch_flush() {
+    ACE_Guard<ACE_Thread_Mutex> guard(_batch_m);
+    message *msg_b = _batch;
+    message *msg_v = _view_batch;
+    _batch      = NULL;
+    _view_batch = NULL;
+    guard.release();
+    
+    if (msg_b) _msg_queue->push(msg_b);
+    if (msg_v) _msg_queue->push(msg_v);
+}
+
+bool
+task_find::flush_expired(const time_value_type &now) {
+    ACE_Guard<ACE_Thread_Mutex> guard(_batch_m);
+    if (_batch == NULL && _view_batch == NULL) return false;
+    if (now - _batch_started < _batch_window)  return false;
+    
+    // Queued while holding the lock, so that the batch cannot end up
+    // after the search done message queued by svc()
+    if (_batch)      _msg_queue->push(_batch);
+    if (_view_batch) _msg_queue->push(_view_batch);
+    _batch      = NULL;
+    _view_batch = NULL;
+    return true;
+}
+
+void
+task_find::_cache_add(const value &v) {
+    ACE_Guard<ACE_Thread_Mutex> guard(_batch_m);
+    _cache_values.push_back(v);
+}
+
+void
+task_find::_cache_decode() {
+    // Called from svc() after the search, no hit callbacks are left
+    _cache_values.reserve(_cache_values.size() + _cache_offsets.size());
+    for (size_t i = 0; i < _cache_offsets.size(); i++) {
+        _cache_values.push_back(value());
+        message_search_view::record(_cache_raw, _cache_offsets, i)
+          .copy(&_cache_values.back());
+    }
+    _cache_raw.clear();
+    _cache_offsets.clear();
 }
 
 int
 task_find::hit_callback(KadCdictionary *d, void *context) {
     ACE_DEBUG((LM_DEBUG, "task_find::hit_callback"));
-    // TODO should check quit signals and return appropriate value
-    // to KadC
     try {
         task_find *self = reinterpret_cast<task_find *>(context);
         
-        auto_ptr<value>          rvalue(new value);
+        // Non-zero ends the KadC search. Set when nobody wants the
+        // results anymore or the client is disconnecting.
+        if (self->quit()) return 1;
+        
+        if (self->_view) {
+            self->_view_add(d);
+            return 0;
+        }
+        if (self->_batch_size > 1) {
+            self->_batch_add(d);
+            return 0;
+        }
+        
         auto_ptr<message_search> 
           msg_s(new message_search(self, client::msg_search_result));
     
-        util::kadc_result(rvalue.get(), d);
+        util::kadc_result(msg_s->result_value(), d);
+        if (self->_cache) self->_cache_add(*msg_s->result_value());
     
         msg_s->success(true);
         msg_s->handler(self->_handler);
         msg_s->search_key(&self->_skey);
-        msg_s->result_value(rvalue.release());
     
-        ACE_Guard<client::message_queue_type> guard_queue(*(self->_msg_queue));
-        self->_msg_queue->push(msg_s.get()); msg_s.release();
+        self->_msg_queue->push(msg_s.release());
         self->_msg_queue->signal();
-        guard_queue.release();  
     } catch (...) {
         ACE_DEBUG((LM_CRITICAL, "dht::kadc::task_find::hit_callback FATAL exception throwed\n"));
         throw;
@@ -92,30 +233,81 @@ task_find::svc(void) {
     msg_d->search_key(&_skey);
     msg_d->success(true);
     
+    char kindex[key128::kadc_index_size];
+    _index.kadc_index(kindex);
+    
+    KadCfind_params fpar;
+    KadCfind_init(&fpar);
+    // 0 leaves KadC's default number of threads
+    if (_params.threads) fpar.threads = _params.threads;
+    size_t threads = fpar.threads > 0 ? fpar.threads : 1;
+    
+    // Task might have been waiting for a free pool worker while 
+    // disconnect was requested
+    admission::result adm = admission::call_aborted;
+    if (!this->quit()) 
+        adm = _admission->acquire(this, &threads, _params.deadline);
+    
+    // Task might have been waiting for a free pool worker or for
+    // admission until the deadline of the search
+    size_t duration = _params.duration;
+    if (adm == admission::call_admitted && 
+        !util::kadc_duration(&duration, _params.deadline)) 
+    {
+        _admission->release(threads);
+        adm = admission::call_expired;
+    }
+    
     ACE_DEBUG((LM_DEBUG, "task_find: searching index: %s, "
                          "threads/duration/max_hits: %d/%d/%d\n",
-                         _index.c_str(),
-                         _client->find_threads(),
-                         _client->find_duration(),
-                         _client->find_max_hits()));
+                         kindex,
+                         threads,
+                         duration,
+                         _params.max_hits));
 
-    KadCfind_params fpar;
-    KadCfind_init(&fpar);
-    fpar.threads  = _client->find_threads();
-    fpar.max_hits = _client->find_max_hits();
-    fpar.duration = _client->find_duration();
-    fpar.hit_callback = task_find::hit_callback;
-    fpar.hit_callback_context = reinterpret_cast<void *>(this);
+    if (adm == admission::call_aborted) {
+        ACE_DEBUG((LM_DEBUG, "task_find: quit before search started\n"));
+        msg_d->success(false);
+        msg_d->code(0);
+        msg_d->string("Search aborted");
+    } else if (adm == admission::call_expired) {
+        ACE_DEBUG((LM_DEBUG, "task_find: deadline passed before search "
+                             "started\n"));
+        msg_d->success(false);
+        msg_d->code(0);
+        msg_d->string("Search deadline passed");
+    } else if (adm == admission::call_rejected) {
+        ACE_DEBUG((LM_DEBUG, "task_find: too many KadC calls running\n"));
+        msg_d->success(false);
+        msg_d->code(client::error_rejected);
+        msg_d->string("Search rejected, too many KadC calls running");
+    } else {
+        // Lowered if over the thread limit
+        if (fpar.threads > (int)threads) fpar.threads = threads;
+        fpar.max_hits = _params.max_hits;
+        fpar.duration = duration;
+        fpar.hit_callback = task_find::hit_callback;
+        fpar.hit_callback_context = reinterpret_cast<void *>(this);
 
-    KadC_find2(_kcc, _index.c_str(), &fpar);
+        KadC_find2(_kcc, kindex, &fpar);
+        _admission->release(threads);
+        
+        // Only complete searches are cached. Searches that found 
+        // nothing are not, since it is likely the network that has
+        // not yet been contacted well enough.
+        if (_cache && !this->quit()) {
+            _cache_decode();
+            if (!_cache_values.empty()) _cache->put(_index, &_cache_values);
+        }
+    }
 
     ACE_DEBUG((LM_DEBUG, "task_find: sending messages\n"));
     
-    ACE_Guard<client::message_queue_type> guard_queue(*_msg_queue); 
-    _msg_queue->push(msg_d.get()); msg_d.release();
-    _msg_queue->push(msg_e.get()); msg_e.release();
+    // Results collected after the last delivered batch
+    _batch_flush();
+    _msg_queue->push(msg_d.release());
+    _msg_queue->push(msg_e.release());
     _msg_queue->signal();
-    guard_queue.release();
 
 #else
     // Search done message, Task exit message, search result message in the loop
@@ -126,18 +318,20 @@ task_find::svc(void) {
     msg_d->handler(_handler);
     msg_d->search_key(&_skey);
     
+    char kindex[key128::kadc_index_size];
+    _index.kadc_index(kindex);
     ACE_DEBUG((LM_DEBUG, "task_find: searching index: %s, "
                          "threads/duration/max_hits: %d/%d/%d\n",
-                         _index.c_str(),
-                         _client->find_threads(),
-                         _client->find_duration(),
-                         _client->find_max_hits()));
+                         kindex,
+                         _params.threads,
+                         _params.duration,
+                         _params.max_hits));
 
 
-    void *resdictrbt = KadC_find(_kcc, _index.c_str(), "", 
-                                 _client->find_threads(),
-                                 _client->find_max_hits(),
-                                 _client->find_duration());
+    void *resdictrbt = KadC_find(_kcc, kindex, "", 
+                                 _params.threads,
+                                 _params.max_hits,
+                                 _params.duration);
 
     try {
         int nhits = rbt_size(resdictrbt);
@@ -150,21 +344,18 @@ task_find::svc(void) {
         for (iter = rbt_begin(resdictrbt); iter != NULL; 
              iter = rbt_next(resdictrbt, iter)) 
         {
-            auto_ptr<value>          rvalue(new value);
             auto_ptr<message_search> 
               msg_s(new message_search(this, client::msg_search_result));
         
-            util::kadc_result(rvalue.get(), rbt_value(iter));
+            util::kadc_result(msg_s->result_value(), 
+                              (KadCdictionary *)rbt_value(iter));
 
             msg_s->success(true);
             msg_s->handler(_handler);
             msg_s->search_key(&_skey);
-            msg_s->result_value(rvalue.release());
 
-            ACE_Guard<client::message_queue_type> guard_queue(*_msg_queue); 
-            _msg_queue->push(msg_s.get()); msg_s.release();
+            _msg_queue->push(msg_s.release());
             _msg_queue->signal();
-            guard_queue.release();          
         }
         util::kadc_free_search_result(resdictrbt);
         
@@ -179,11 +370,9 @@ task_find::svc(void) {
 
     ACE_DEBUG((LM_DEBUG, "task_find: sending messages\n"));
     
-    ACE_Guard<client::message_queue_type> guard_queue(*_msg_queue); 
-    _msg_queue->push(msg_d.get()); msg_d.release();
-    _msg_queue->push(msg_e.get()); msg_e.release();
+    _msg_queue->push(msg_d.release());
+    _msg_queue->push(msg_e.release());
     _msg_queue->signal();
-    guard_queue.release();
 #endif
 
     ACE_DEBUG((LM_DEBUG, "task_find: exiting thread\n"));
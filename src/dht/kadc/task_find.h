@@ -2,10 +2,15 @@
 #define DHT_KADC_TASK_FIND_H_
 
 #include <string>
+#include <vector>
+
+#include <ace/Thread_Mutex.h>
 
 #include "../key.h"
 #include "task.h"
 #include "client.h"
+#include "result_cache.h"
+#include "key128.h"
 
 namespace dht {
 namespace kadc {
@@ -15,28 +20,60 @@ namespace kadc {
         client::message_queue_type *_msg_queue;
 
         key             _skey;      
-        string          _index;
+        key128          _index;
         search_handler *_handler;
         KadCcontext    *_kcc;
+        find_params     _params;
+        admission      *_admission;
+        
+        // Results collected for delivering them with one message
+        ACE_Thread_Mutex            _batch_m;
+        class message_search_batch *_batch;
+        // Used instead of _batch if results are delivered as views
+        class message_search_view  *_view_batch;
+        bool                        _view;
+        time_value_type             _batch_started;
+        size_t                      _batch_size;
+        time_value_type             _batch_window;
+        
+        // Results collected for the result cache, NULL if not caching.
+        // Also guarded by _batch_m.
+        result_cache               *_cache;
+        result_cache::values_type   _cache_values;
+        // With views the cached results are kept as raw records, and
+        // decoded to _cache_values only if the search is cached
+        std::string                 _cache_raw;
+        std::vector<size_t>         _cache_offsets;
         
-#if 0
-        // TODO configurable...
-        // KadC parameters, use defaults when applicable
-        const static int _nthreads = 0;
-        const static int _duration = 0;
-        const static int _max_hits = 500;
-#endif
+        void _batch_add(KadCdictionary *d);
+        void _view_add(KadCdictionary *d);
+        void _batch_flush();
+        void _cache_add(const value &v);
+        void _cache_decode();
     public:
+        // Takes the key by swapping it with the given one. params 
+        // must have the client's defaults filled in.
         task_find(client *n,
                   client::message_queue_type *q,
                   KadCcontext             *kcc,
-                  const key               &skey,
-                  search_handler          *h);
+                  key                     *skey,
+                  search_handler          *h,
+                  const find_params       &params);
 
         virtual ~task_find();
         
         virtual int svc(void);
         
+        inline const key128 &index() const { return _index; }
+        
+        // Delivers the collected results if find_batch_window() has
+        // passed from the first of them. Called from the reactor 
+        // thread, so that a batch is not held until the next result.
+        // Returns true if a message was queued.
+        bool flush_expired(const time_value_type &now);
+        
+        // Computes the KadC index of a search key
+        static void make_index(key128 *index, const key &skey);
         static int hit_callback(KadCdictionary *d, void *context);
     };
     
@@ -0,0 +1,84 @@
+#include <memory>
+
+#include "task_find_cached.h"
+#include "message_search.h"
+#include "message_search_batch.h"
+
+using namespace std;
+
+namespace dht {
+namespace kadc {
+
+task_find_cached::task_find_cached(client *n,
+                                   client::message_queue_type *q,
+                                   key                        *skey,
+                                   result_cache::values_type  *values,
+                                   search_handler             *h) 
+  : task("cached search")
+{
+    _client    = n;
+    _msg_queue = q;
+    _handler   = h;
+    _skey.swap(*skey);
+    _values.swap(*values);
+}
+
+task_find_cached::~task_find_cached() {
+}
+
+int 
+task_find_cached::svc(void) {
+    ACE_TRACE("task_find_cached::svc");
+    
+    auto_ptr<message>        msg_e(new message(this, client::msg_task_exit));
+    auto_ptr<message_search> 
+      msg_d(new message_search(this, client::msg_search_done));
+
+    msg_d->handler(_handler);
+    msg_d->search_key(&_skey);
+    msg_d->success(true);
+
+    ACE_DEBUG((LM_DEBUG, "task_find_cached: delivering %d cached results\n",
+               _values.size()));
+    
+    // Results are delivered in the same way as by task_find
+    size_t batch_size = _client->find_batch_size();
+    size_t i = 0;
+    while (i < _values.size()) {
+        if (batch_size > 1) {
+            auto_ptr<message_search_batch> 
+              msg_b(new message_search_batch(this, client::msg_search_batch,
+                                             batch_size));
+            message_search_batch::values_type &vs = msg_b->result_values();
+            // The values are owned by this task, so they are moved to
+            // the messages
+            for (; i < _values.size() && vs.size() < batch_size; i++) {
+                vs.push_back(value());
+                vs.back().swap(_values[i]);
+            }
+            
+            msg_b->success(true);
+            msg_b->handler(_handler);
+            msg_b->search_key(&_skey);
+            _msg_queue->push(msg_b.release());
+        } else {
+            auto_ptr<message_search> 
+              msg_s(new message_search(this, client::msg_search_result));
+            msg_s->result_value()->swap(_values[i++]);
+            
+            msg_s->success(true);
+            msg_s->handler(_handler);
+            msg_s->search_key(&_skey);
+            _msg_queue->push(msg_s.release());
+        }
+    }
+    
+    _msg_queue->push(msg_d.release());
+    _msg_queue->push(msg_e.release());
+    _msg_queue->signal();
+    
+    return 0;
+}
+
+} // ns kadc
+} // ns dht
@@ -0,0 +1,39 @@
+#ifndef DHT_KADC_TASK_FIND_CACHED_H_
+#define DHT_KADC_TASK_FIND_CACHED_H_
+
+#include "../key.h"
+#include "task.h"
+#include "client.h"
+#include "result_cache.h"
+
+namespace dht {
+namespace kadc {
+    // Delivers search results found from the result cache. Not run in
+    // a thread of its own: svc() is called directly in find(), and it
+    // only queues the messages that a task_find would send, so the 
+    // handler gets the results on the next process() call.
+    class task_find_cached : public task {
+        client                     *_client;
+        client::message_queue_type *_msg_queue;
+
+        key                        _skey;
+        result_cache::values_type  _values;
+        search_handler            *_handler;
+    public:
+        // Takes the key and the values by swapping them with the 
+        // given ones
+        task_find_cached(client *n,
+                         client::message_queue_type *q,
+                         key                        *skey,
+                         result_cache::values_type  *values,
+                         search_handler             *h);
+
+        virtual ~task_find_cached();
+        
+        virtual int svc(void);
+    };
+    
+} // ns kadc
+} // ns dht
+
+#endif //DHT_KADC_TASK_FIND_CACHED_H_
@@ -0,0 +1,174 @@
+#include <memory>
+
+#include <ace/Guard_T.h>
+
+#include "../exception.h"
+#include "task_find_many.h"
+#include "task_find.h"
+#include "message_search_many.h"
+#include "client.h"
+#include "util.h"
+
+using namespace std;
+
+namespace dht {
+namespace kadc {
+
+task_find_many::task_find_many(client *n,
+                               client::message_queue_type *q,
+                               KadCcontext                *kcc,
+                               const key                  *begin,
+                               const key                  *end,
+                               search_handler             *h) 
+  : task_parts("search many", end - begin, n->find_many_threads())
+{
+    _items.resize(end - begin);
+    for (size_t i = 0; begin != end; begin++, i++) {
+        item &it = _items[i];
+        task_find::make_index(&it.index, *begin);
+        it.owner   = this;
+        it.pos     = i;
+        it.skey    = *begin;
+        it.cache_m = &_cache_m;
+        it.stopped = false;
+    }
+
+    _client    = n;
+    _msg_queue = q;
+    _kcc       = kcc;
+    _handler   = h;
+    n->find_defaults(&_params);
+    _admission = n->kadc_admission();
+    priority(prio_normal);
+    _cache     = n->find_cache();
+}
+
+task_find_many::~task_find_many() {
+}
+
+int
+task_find_many::hit_callback(KadCdictionary *d, void *context) {
+    try {
+        item *it = reinterpret_cast<item *>(context);
+        
+        // Non-zero ends the KadC search of the key
+        if (it->stopped || it->owner->quit()) return 1;
+        
+        auto_ptr<message_search_many> 
+          msg_s(new message_search_many(it->owner, 
+                                        client::msg_search_many_result,
+                                        it->pos));
+        util::kadc_result(msg_s->result_value(), d);
+        if (it->owner->_cache) {
+            ACE_Guard<ACE_Thread_Mutex> guard(*it->cache_m);
+            it->cache_values.push_back(*msg_s->result_value());
+        }
+        
+        msg_s->success(true);
+        msg_s->handler(it->owner->_handler);
+        msg_s->search_key(&it->skey);
+    
+        it->owner->_msg_queue->push(msg_s.release());
+        it->owner->_msg_queue->signal();
+    } catch (...) {
+        ACE_DEBUG((LM_CRITICAL, "dht::kadc::task_find_many::hit_callback FATAL exception throwed\n"));
+        throw;
+    }
+    return 0;
+}
+
+void
+task_find_many::_search(item *it) {
+    auto_ptr<message_search_many> 
+      msg_d(new message_search_many(this, client::msg_search_key_done,
+                                    it->pos));
+    msg_d->handler(_handler);
+    msg_d->search_key(&it->skey);
+    msg_d->success(true);
+    
+    result_cache::values_type values;
+    if (this->quit()) {
+        msg_d->success(false);
+        msg_d->code(0);
+        msg_d->string("Search aborted");
+    } else if (_cache && _cache->get(it->index, &values)) {
+        // Cached results are delivered without searching
+        for (size_t i = 0; i < values.size(); i++) {
+            auto_ptr<message_search_many> 
+              msg_s(new message_search_many(this, 
+                                            client::msg_search_many_result,
+                                            it->pos));
+            msg_s->result_value()->swap(values[i]);
+            msg_s->success(true);
+            msg_s->handler(_handler);
+            msg_s->search_key(&it->skey);
+            _msg_queue->push(msg_s.release());
+        }
+    } else {
+        KadCfind_params fpar;
+        KadCfind_init(&fpar);
+        if (_params.threads) fpar.threads = _params.threads;
+        size_t threads = fpar.threads > 0 ? fpar.threads : 1;
+        
+        // Each key is admitted separately, like the calls of find()
+        admission::result adm = 
+            _admission->acquire(this, &threads, time_value_type::zero);
+        if (adm == admission::call_rejected) {
+            msg_d->success(false);
+            msg_d->code(client::error_rejected);
+            msg_d->string("Search rejected, too many KadC calls running");
+        } else if (adm != admission::call_admitted) {
+            msg_d->success(false);
+            msg_d->code(0);
+            msg_d->string("Search aborted");
+        } else {
+            if (fpar.threads > (int)threads) fpar.threads = threads;
+            fpar.max_hits = _params.max_hits;
+            fpar.duration = _params.duration;
+            fpar.hit_callback = task_find_many::hit_callback;
+            fpar.hit_callback_context = reinterpret_cast<void *>(it);
+
+            char kindex[key128::kadc_index_size];
+            it->index.kadc_index(kindex);
+            KadC_find2(_kcc, kindex, &fpar);
+            _admission->release(threads);
+            
+            // Cached with the same rules as in task_find
+            ACE_Guard<ACE_Thread_Mutex> guard(_cache_m);
+            if (_cache && !this->quit() && !it->cache_values.empty())
+                _cache->put(it->index, &it->cache_values);
+        }
+    }
+    
+    _msg_queue->push(msg_d.release());
+    _msg_queue->signal();
+}
+
+void
+task_find_many::work(size_t i) {
+    _search(&_items[i]);
+}
+
+int 
+task_find_many::svc(void) {
+    ACE_TRACE("task_find_many::svc");
+    auto_ptr<message> msg_e(new message(this, client::msg_task_exit));
+    auto_ptr<message> msg_d(new message(this, client::msg_search_many_done));
+    
+    msg_d->handler(_handler);
+    msg_d->success(true);
+    
+    ACE_DEBUG((LM_DEBUG, "task_find_many: searched %d keys with %d "
+                         "parts\n", _items.size(), parts()));
+
+    _msg_queue->push(msg_d.release());
+    _msg_queue->push(msg_e.release());
+    _msg_queue->signal();
+
+    ACE_DEBUG((LM_DEBUG, "task_find_many: done\n"));
+    
+    return 0;
+}
+
+} // ns kadc
+} // ns dht
@@ -0,0 +1,71 @@
+#ifndef DHT_KADC_TASK_FIND_MANY_H_
+#define DHT_KADC_TASK_FIND_MANY_H_
+
+#include <string>
+#include <vector>
+
+#include <ace/Thread_Mutex.h>
+
+#include "../key.h"
+#include "task_parts.h"
+#include "client.h"
+#include "result_cache.h"
+#include "key128.h"
+
+namespace dht {
+namespace kadc {
+    // Searches many keys. The keys are searched by parts run by the
+    // task pool like other finds, each running one KadC_find2 at a
+    // time.
+    class task_find_many : public task_parts {
+        struct item {
+            task_find_many *owner;
+            size_t          pos;
+            key             skey;
+            key128          index;
+            // Results collected for the result cache
+            ACE_Thread_Mutex          *cache_m;
+            result_cache::values_type  cache_values;
+            // Set by the reactor thread when the handler does not want
+            // more results of the key, read by the KadC hit callback
+            volatile bool   stopped;
+        };
+        typedef std::vector<item> items_type;
+        
+        client                     *_client;
+        client::message_queue_type *_msg_queue;
+        items_type      _items;
+        search_handler *_handler;
+        KadCcontext    *_kcc;
+        find_params     _params;
+        admission      *_admission;
+        result_cache   *_cache;
+        ACE_Thread_Mutex _cache_m;
+        
+        void _search(item *it);
+    protected:
+        virtual void work(size_t i);
+    public:
+        task_find_many(client *n,
+                       client::message_queue_type *q,
+                       KadCcontext                *kcc,
+                       const key                  *begin,
+                       const key                  *end,
+                       search_handler             *h);
+
+        virtual ~task_find_many();
+
+        // Sends the end of the whole operation, run by the last part
+        virtual int svc(void);
+        
+        // Used by the reactor thread
+        inline bool stopped(size_t i) const { return _items[i].stopped; }
+        inline void stop(size_t i)          { _items[i].stopped = true; }
+        
+        static int hit_callback(KadCdictionary *d, void *context);
+    };
+
+} // ns kadc
+} // ns dht
+
+#endif //DHT_KADC_TASK_FIND_MANY_H_
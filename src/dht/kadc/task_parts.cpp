@@ -0,0 +1,51 @@
+#include <algorithm>
+
+#include "task_parts.h"
+#include "atomic.h"
+
+namespace dht {
+namespace kadc {
+
+task_parts::task_parts(const char *id, size_t items, size_t parts)
+  : task(id), _items(items), _next(0)
+{
+    parts = std::max<size_t>(std::min(parts, items), 1);
+    for (size_t i = 0; i < parts; i++) _parts.push_back(new part(this));
+    _running = parts;
+    pooled(true);
+}
+
+task_parts::~task_parts() {
+    for (size_t i = 0; i < _parts.size(); i++) {
+        _parts[i]->join();
+        delete _parts[i];
+    }
+}
+
+int
+task_parts::_work() {
+    for (;;) {
+        unsigned long i = atomic::add(&_next, 1UL) - 1;
+        if (i >= _items) break;
+        work(i);
+    }
+    _part_done();
+    return 0;
+}
+
+void
+task_parts::_part_done() {
+    // The owner may be deleted as soon as it has run, so the part
+    // must not touch it after this
+    if (atomic::add(&_running, (unsigned long)-1) == 0) this->run();
+}
+
+void
+task_parts::part_skipped() {
+    // A part that was not started is not pooled and has no thread,
+    // so joining it returns at once
+    _part_done();
+}
+
+} // ns kadc
+} // ns dht
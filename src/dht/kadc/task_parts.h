@@ -0,0 +1,60 @@
+#ifndef DHT_KADC_TASK_PARTS_H_
+#define DHT_KADC_TASK_PARTS_H_
+
+#include <vector>
+
+#include "task.h"
+
+namespace dht {
+namespace kadc {
+    /**
+     * A task whose items are worked on by parts, each a task of its
+     * own that the client submits to the task_pool with the priority
+     * of the owner (or runs in a thread of its own without a pool).
+     * The parts take the next item until none are left, so any
+     * number of them that get to run do all the work.
+     *
+     * The owner itself is not run by a worker. The last part to
+     * finish runs it, and its svc() sends the messages that end the
+     * operation. The owner is marked pooled, so task::join() waits
+     * for that.
+     */
+    class task_parts : public task {
+        class part : public task {
+            task_parts *_owner;
+        public:
+            part(task_parts *o) : task("part"), _owner(o) {}
+            virtual int svc(void) { return _owner->_work(); }
+        };
+        typedef std::vector<part *> parts_type;
+
+        parts_type _parts;
+        size_t     _items;
+        // Next item to work on and parts that have not finished,
+        // updated atomically by the parts
+        volatile unsigned long _next;
+        volatile unsigned long _running;
+
+        int  _work();
+        void _part_done();
+    protected:
+        // Works on item i, called by the parts
+        virtual void work(size_t i) = 0;
+    public:
+        // At least one part is created, so that the owner is run
+        // even without items
+        task_parts(const char *id, size_t items, size_t parts);
+        // Waits for the parts to finish and deletes them
+        virtual ~task_parts();
+
+        inline size_t parts() const     { return _parts.size(); }
+        inline task  *part_at(size_t i) { return _parts[i]; }
+        // Called by the client for a part that it could not start,
+        // the other parts do its work
+        void part_skipped();
+    };
+
+} // ns kadc
+} // ns dht
+
+#endif //DHT_KADC_TASK_PARTS_H_
@@ -0,0 +1,200 @@
+#include <ace/Guard_T.h>
+#include <ace/OS_NS_sys_time.h>
+
+#include "task_pool.h"
+
+namespace dht {
+namespace kadc {
+
+task_pool::task_pool()
+  : _max_queued(0), _queued(0), _workers(0), _busy(0), _peak_busy(0),
+    _completed(0), _stopping(false), _cond(_m)
+{
+    for (int c = 0; c < prio_classes; c++) {
+        _limit[c]   = 0;
+        _running[c] = 0;
+    }
+}
+
+task_pool::~task_pool() {
+    stop();
+}
+
+void
+task_pool::limit(int prio, size_t max_running) {
+    ACE_Guard<ACE_Thread_Mutex> guard(_m);
+    _limit[prio] = max_running;
+    // Tasks held back by the old limit may be runnable now
+    _cond.broadcast();
+}
+
+size_t
+task_pool::limit(int prio) const {
+    ACE_Guard<ACE_Thread_Mutex> guard(_m);
+    return _limit[prio];
+}
+
+int
+task_pool::start(size_t workers, size_t max_queued) {
+    ACE_Guard<ACE_Thread_Mutex> guard(_m);
+    _workers    = workers;
+    _max_queued = max_queued;
+    _stopping   = false;
+    guard.release();
+
+    ACE_DEBUG((LM_DEBUG, "task_pool: starting %d workers, max queued %d\n",
+              workers, max_queued));
+    return this->activate(THR_NEW_LWP | THR_JOINABLE, (int)workers);
+}
+
+void
+task_pool::stop() {
+    ACE_Guard<ACE_Thread_Mutex> guard(_m);
+    _stopping = true;
+    _cond.broadcast();
+    guard.release();
+
+    this->wait();
+    ACE_DEBUG((LM_DEBUG, "task_pool: workers stopped\n"));
+}
+
+bool
+task_pool::submit(task *t) {
+    entry e;
+    e.t         = t;
+    e.queued_at = ACE_OS::gettimeofday();
+
+    int prio = t->priority();
+    if (prio < 0 || prio >= prio_classes) prio = prio_normal;
+
+    ACE_Guard<ACE_Thread_Mutex> guard(_m);
+    if (_max_queued && _queued >= _max_queued) {
+        ACE_DEBUG((LM_WARNING, "task_pool: queue full (%d tasks), " \
+                  "rejecting task %s\n", _queued, t->id()));
+        return false;
+    }
+    t->pooled(true);
+    _queue[prio].push_back(e);
+    _queued++;
+    _cond.signal();
+
+    return true;
+}
+
+int
+task_pool::_next_class() const {
+    for (int c = 0; c < prio_classes; c++) {
+        if (_queue[c].empty()) continue;
+        if (_limit[c] == 0 || _running[c] < _limit[c]) return c;
+    }
+    return -1;
+}
+
+size_t
+task_pool::workers() const {
+    ACE_Guard<ACE_Thread_Mutex> guard(_m);
+    return _workers;
+}
+
+size_t
+task_pool::max_queued() const {
+    ACE_Guard<ACE_Thread_Mutex> guard(_m);
+    return _max_queued;
+}
+
+size_t
+task_pool::busy() const {
+    ACE_Guard<ACE_Thread_Mutex> guard(_m);
+    return _busy;
+}
+
+size_t
+task_pool::peak_busy() const {
+    ACE_Guard<ACE_Thread_Mutex> guard(_m);
+    return _peak_busy;
+}
+
+size_t
+task_pool::queued() const {
+    ACE_Guard<ACE_Thread_Mutex> guard(_m);
+    return _queued;
+}
+
+size_t
+task_pool::queued(int prio) const {
+    ACE_Guard<ACE_Thread_Mutex> guard(_m);
+    return _queue[prio].size();
+}
+
+size_t
+task_pool::running(int prio) const {
+    ACE_Guard<ACE_Thread_Mutex> guard(_m);
+    return _running[prio];
+}
+
+size_t
+task_pool::completed() const {
+    ACE_Guard<ACE_Thread_Mutex> guard(_m);
+    return _completed;
+}
+
+queue_wait_stats
+task_pool::queue_wait(int prio) const {
+    ACE_Guard<ACE_Thread_Mutex> guard(_m);
+    return _wait[prio];
+}
+
+void
+task_pool::queue_wait_reset() {
+    ACE_Guard<ACE_Thread_Mutex> guard(_m);
+    for (int c = 0; c < prio_classes; c++)
+        _wait[c] = queue_wait_stats();
+}
+
+int
+task_pool::svc(void) {
+    ACE_TRACE("task_pool::svc");
+    ACE_Guard<ACE_Thread_Mutex> guard(_m);
+
+    while (1) {
+        // A worker that finishes a task checks the queues again itself,
+        // so tasks held back by a class limit are not left waiting
+        int c;
+        while ((c = _next_class()) == -1 && !(_stopping && _queued == 0))
+            _cond.wait();
+        // Queued tasks are always run before exiting, since the client
+        // waits for every task it has submitted
+        if (c == -1) break;
+
+        entry e = _queue[c].front();
+        _queue[c].pop_front();
+        _queued--;
+        _running[c]++;
+        if (++_busy > _peak_busy) _peak_busy = _busy;
+
+        time_value_type waited = ACE_OS::gettimeofday() - e.queued_at;
+        queue_wait_stats &w = _wait[c];
+        w.started++;
+        w.total += waited;
+        if (waited > w.max) w.max = waited;
+        guard.release();
+
+        ACE_DEBUG((LM_DEBUG, "%t task_pool: running task %s\n", e.t->id()));
+        // The task can be deleted by the client as soon as run()
+        // returns, so it must not be touched after this.
+        e.t->run();
+
+        guard.acquire();
+        _running[c]--;
+        _busy--;
+        _completed++;
+        // Workers held back by a class limit wait for the last task
+        if (_stopping) _cond.broadcast();
+    }
+
+    ACE_DEBUG((LM_DEBUG, "%t task_pool: worker exiting\n"));
+    return 0;
+}
+
+} // ns kadc
+} // ns dht
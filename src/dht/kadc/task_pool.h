@@ -0,0 +1,109 @@
+#ifndef DHT_KADC_TASK_POOL_H_
+#define DHT_KADC_TASK_POOL_H_
+
+#include <ace/Condition_T.h>
+#include <ace/Thread_Mutex.h>
+#include <ace/Task.h>
+
+#include <deque>
+
+#include "../common.h"
+#include "params.h"
+#include "task.h"
+
+namespace dht {
+namespace kadc {
+    /**
+     * Time tasks of a priority class have waited in the task_pool
+     * queue before a worker started running them.
+     */
+    struct queue_wait_stats {
+        // Number of tasks started
+        unsigned long   started;
+        time_value_type total;
+        time_value_type max;
+
+        queue_wait_stats() : started(0) {}
+    };
+
+    /**
+     * A fixed number of prespawned worker threads that run tasks
+     * from a bounded queue. Used for find and store tasks so that
+     * each operation does not create and join an OS thread of its own.
+     *
+     * Tasks wait in a FIFO queue of their priority_class. A free
+     * worker takes the first task of the highest class that has
+     * fewer tasks running than its limit, so queued interactive
+     * tasks are started before background ones that were queued
+     * earlier. Running tasks are not interrupted.
+     *
+     * Tasks run by the pool are marked as pooled, so that task::join()
+     * waits for the task's svc() to finish instead of joining a thread.
+     */
+    class task_pool : public ACE_Task_Base {
+        struct entry {
+            task           *t;
+            time_value_type queued_at;
+        };
+        typedef std::deque<entry> queue_type;
+
+        queue_type _queue[prio_classes];
+        size_t     _limit[prio_classes];
+        size_t     _running[prio_classes];
+        queue_wait_stats _wait[prio_classes];
+        size_t     _max_queued;
+        size_t     _queued;
+        size_t     _workers;
+        size_t     _busy;
+        size_t     _peak_busy;
+        size_t     _completed;
+        bool       _stopping;
+
+        mutable ACE_Thread_Mutex        _m;
+        ACE_Condition<ACE_Thread_Mutex> _cond;
+
+        // Class whose first task can be run next, -1 if none
+        int _next_class() const;
+    public:
+        task_pool();
+        virtual ~task_pool();
+
+        // Sets the maximum number of tasks of a priority class running
+        // at the same time, 0 for no limit besides the workers.
+        void limit(int prio, size_t max_running);
+        size_t limit(int prio) const;
+
+        // Spawns the worker threads. max_queued of 0 means unbounded queue.
+        int start(size_t workers, size_t max_queued);
+        // Lets the workers finish already queued tasks and waits
+        // for them to exit.
+        void stop();
+
+        // Queues the task for running with the task's priority.
+        // Returns false if the queue is full.
+        bool submit(task *t);
+
+        size_t workers()    const;
+        size_t max_queued() const;
+        // Number of workers currently running a task
+        size_t busy()       const;
+        // Highest number of workers that have been busy at the same time
+        size_t peak_busy()  const;
+        // Number of tasks waiting for a free worker
+        size_t queued()     const;
+        size_t queued(int prio) const;
+        // Number of tasks of the class being run
+        size_t running(int prio) const;
+        // Number of tasks the workers have finished running
+        size_t completed()  const;
+        // Queue waits of the class since start or the last reset
+        queue_wait_stats queue_wait(int prio) const;
+        void queue_wait_reset();
+
+        virtual int svc(void);
+    };
+
+} // ns kadc
+} // ns dht
+
+#endif //DHT_KADC_TASK_POOL_H_
@@ -0,0 +1,71 @@
+#include <memory>
+
+#include <ace/Guard_T.h>
+#include <ace/OS_NS_stdio.h>
+
+#include "task_snapshot.h"
+#include "client.h"
+
+using namespace std;
+
+namespace dht {
+namespace kadc {
+
+task_snapshot::task_snapshot(client                     *n,
+                             client::message_queue_type *q,
+                             KadCcontext                *kcc) 
+  : task("snapshot")
+{
+    _msg_queue = q;
+    _kcc       = kcc;
+    _file      = n->snapshot_file();
+    _interval  = n->snapshot_interval();
+}
+
+task_snapshot::~task_snapshot() {
+}
+
+bool
+task_snapshot::_write() {
+    // Written to a temporary file first, so that the snapshot file
+    // is complete even if the process is killed while writing
+    string tmp = _file + ".tmp";
+    int kcs = KadC_write_inifile(_kcc, tmp.c_str());
+    if (kcs != 0) {
+        ACE_DEBUG((LM_DEBUG, "task_snapshot: KadC_write_inifile(%s) "
+                             "returned error %d\n", tmp.c_str(), kcs));
+        return false;
+    }
+    if (ACE_OS::rename(tmp.c_str(), _file.c_str()) == -1) {
+        ACE_DEBUG((LM_DEBUG, "task_snapshot: could not rename %s to %s\n",
+                   tmp.c_str(), _file.c_str()));
+        return false;
+    }
+    ACE_DEBUG((LM_DEBUG, "task_snapshot: wrote %s, %d contacts\n",
+               _file.c_str(), KadC_getncontacts(_kcc)));
+    return true;
+}
+
+int 
+task_snapshot::svc(void) {
+    ACE_TRACE("task_snapshot::svc");
+    auto_ptr<message> msg_e(new message(this, client::msg_task_exit));
+    
+    ACE_Guard<task_snapshot> guard(*this);
+    while (!this->quit()) {
+        // Returns early when quit is signaled
+        this->wait(_interval);
+        if (this->quit()) break;
+        _write();
+    }
+    guard.release();
+    
+    ACE_DEBUG((LM_DEBUG, "task_snapshot: sending messages\n"));
+    _msg_queue->push(msg_e.release());
+    _msg_queue->signal();
+    
+    return 0;
+}
+
+} // ns kadc
+} // ns dht
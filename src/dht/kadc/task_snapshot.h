@@ -0,0 +1,32 @@
+#ifndef DHT_KADC_TASK_SNAPSHOT_H_
+#define DHT_KADC_TASK_SNAPSHOT_H_
+
+#include <string>
+
+#include "task.h"
+#include "client.h"
+
+namespace dht {
+namespace kadc {
+    // Writes KadC's contacts periodically to the snapshot file while
+    // connected. Runs in a thread of its own until quit.
+    class task_snapshot : public task {
+        client::message_queue_type *_msg_queue;
+        KadCcontext                *_kcc;
+        std::string                 _file;
+        time_value_type             _interval;
+        
+        bool _write();
+    public:
+        task_snapshot(client                     *n,
+                      client::message_queue_type *q,
+                      KadCcontext                *kcc);
+        virtual ~task_snapshot();
+        
+        virtual int svc(void);
+    };
+    
+} // ns kadc
+} // ns dht
+
+#endif //DHT_KADC_TASK_SNAPSHOT_H_
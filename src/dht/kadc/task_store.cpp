@@ -5,6 +5,7 @@
 #include "../exception.h"
 #include "task_store.h"
 #include "client.h"
+#include "result_cache.h"
 #include "util.h"
 
 using namespace std;
@@ -17,7 +18,8 @@ task_store::task_store(client *n,
                        KadCcontext             *kcc,
                        const key               &pkey,
                        const value             &pvalue,
-                       notify_handler          *h) : task("store")
+                       notify_handler          *h,
+                       const store_params      &params) : task("store")
 {
     if (!pkey.allow_hash_transform() && pkey.size() > 16)
         throw call_errorf(
@@ -31,16 +33,17 @@ task_store::task_store(client *n,
             pvalue.size()
         );
 
-    util::kadc_hash(&_index, pkey.data(), pkey.size(), 
-                    pkey.allow_hash_transform());
-    util::kadc_hash(&_value, pvalue.data(), pvalue.size(), 
-                    pvalue.allow_hash_transform());
+    util::kadc_hash(&_index, pkey);
+    util::kadc_hash(&_value, pvalue);
     util::kadc_meta(&_meta, pvalue.meta());
     
     _client      = n;
     _msg_queue = q;
     _kcc       = kcc;
     _notify    = h;
+    _params    = params;
+    _admission = n->kadc_admission();
+    priority(params.priority);
 }
 
 task_store::~task_store() {
@@ -55,26 +58,75 @@ task_store::svc(void) {
     
     msg_p->handler(_notify);
     
-    size_t threads   = _client->store_threads();
-    size_t duration  = _client->store_duration();   
+    size_t threads   = _params.threads;
+    size_t duration  = _params.duration;   
     // For some reason KadC_republish does not set the defaults,
     // so do it manually here
     if (threads == 0)  threads = 5;   // 5 threads by default
     if (duration == 0) duration = 15; // 15 secs by default
 
+    char kindex[key128::kadc_index_size];
+    char kvalue[key128::kadc_index_size];
+    _index.kadc_index(kindex);
+    _value.kadc_index(kvalue);
+    
+    // Task might have been waiting for a free pool worker while 
+    // disconnect was requested
+    admission::result adm = admission::call_aborted;
+    if (!this->quit()) 
+        adm = _admission->acquire(this, &threads, _params.deadline);
+    
+    // Task might have been waiting for a free pool worker or for 
+    // admission until the deadline
+    if (adm == admission::call_admitted &&
+        !util::kadc_duration(&duration, _params.deadline))
+    {
+        _admission->release(threads);
+        adm = admission::call_expired;
+    }
+    
     ACE_DEBUG((LM_DEBUG, "task_store: store index/value: %s/%s, " 
                          "threads/duration: %d/%d\n",
-                         _index.c_str(), _value.c_str(),
+                         kindex, kvalue,
                          threads, duration));
     
-    int kcs = KadC_republish(_kcc, 
-                             _index.c_str(), 
-                             _value.c_str(), 
+    int kcs;
+    if (adm == admission::call_aborted) {
+        kcs = -2;
+    } else if (adm == admission::call_expired) {
+        kcs = -3;
+    } else if (adm == admission::call_rejected) {
+        kcs = -4;
+    } else {
+        kcs = KadC_republish(_kcc, 
+                             kindex, 
+                             kvalue, 
                              // "",
                              _meta.c_str(),
                              threads, duration);
+        _admission->release(threads);
+    }
                              
-    if (kcs == -1) {
+    if (kcs == -2) {
+        ACE_DEBUG((LM_DEBUG, "task_store: quit before publish started\n"));
+
+        msg_p->success(false);
+        msg_p->code(0);
+        msg_p->string("Publishing aborted");
+    } else if (kcs == -3) {
+        ACE_DEBUG((LM_DEBUG, "task_store: deadline passed before publish "
+                             "started\n"));
+
+        msg_p->success(false);
+        msg_p->code(0);
+        msg_p->string("Publishing deadline passed");
+    } else if (kcs == -4) {
+        ACE_DEBUG((LM_DEBUG, "task_store: too many KadC calls running\n"));
+
+        msg_p->success(false);
+        msg_p->code(client::error_rejected);
+        msg_p->string("Publishing rejected, too many KadC calls running");
+    } else if (kcs == -1) {
         ACE_DEBUG((LM_DEBUG, "task_store: KadC_republish returned error\n"));
 
         msg_p->success(false);
@@ -91,15 +143,15 @@ task_store::svc(void) {
         ACE_DEBUG((LM_DEBUG, "task_store: store success, number of peer " \
                              "nodes where value was stored: %d\n", kcs));
         msg_p->success(true);
+        // Cached results of the key would not contain the new value
+        if (_client->find_cache()) _client->find_cache()->erase(_index);
     }
     
     ACE_DEBUG((LM_DEBUG, "task_store: sending messages\n"));
     
-    ACE_Guard<client::message_queue_type> guard_queue(*_msg_queue); 
-    _msg_queue->push(msg_p.get()); msg_p.release();
-    _msg_queue->push(msg_e.get()); msg_e.release();
+    _msg_queue->push(msg_p.release());
+    _msg_queue->push(msg_e.release());
     _msg_queue->signal();
-    guard_queue.release();
 
     ACE_DEBUG((LM_DEBUG, "task_store: exiting thread\n"));
     
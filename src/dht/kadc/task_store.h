@@ -5,25 +5,30 @@
 
 #include "task.h"
 #include "client.h"
+#include "key128.h"
 
 namespace dht {
 namespace kadc {
     class task_store : public task {
         client                     *_client;
         client::message_queue_type *_msg_queue;
-        std::string     _index;
-        std::string     _value;
+        key128          _index;
+        key128          _value;
         std::string     _meta;
         notify_handler *_notify;
         KadCcontext    *_kcc;
+        store_params    _params;
+        admission      *_admission;
 
     public:
+        // params must have the client's defaults filled in
         task_store(client *n,
                    client::message_queue_type *q,
                    KadCcontext             *kcc,
                    const key   &pkey,
                    const value &pvalue,
-                   notify_handler *h);
+                   notify_handler *h,
+                   const store_params &params);
 
         virtual ~task_store();
 
@@ -0,0 +1,160 @@
+#include <memory>
+
+#include "../exception.h"
+#include "task_store_many.h"
+#include "message_store.h"
+#include "result_cache.h"
+#include "atomic.h"
+#include "client.h"
+#include "util.h"
+
+using namespace std;
+
+namespace dht {
+namespace kadc {
+
+task_store_many::task_store_many(client *n,
+                                 client::message_queue_type *q,
+                                 KadCcontext                *kcc,
+                                 const client::key_value    *begin,
+                                 const client::key_value    *end,
+                                 notify_handler             *h) 
+  : task_parts("store many", end - begin, n->store_many_threads())
+{
+    _items.resize(end - begin);
+    items_type::iterator it = _items.begin();
+    for (; begin != end; begin++, it++) {
+        const key   &pkey   = begin->first;
+        const value &pvalue = begin->second;
+        
+        if (!pkey.allow_hash_transform() && pkey.size() > 16)
+            throw call_errorf(
+                "dht::kadc::store_many too big a key given " \
+                "max key length 16 bytes, given key is %d bytes",
+                pkey.size());
+        if (!pvalue.allow_hash_transform() && pvalue.size() > 16)
+            throw call_errorf(
+                "dht::kadc::store_many too big a value given " \
+                "max value length 16 bytes, given value is %d bytes",
+                pvalue.size()
+            );
+        
+        it->skey   = pkey;
+        it->svalue = pvalue;
+        util::kadc_hash(&it->index, pkey);
+        util::kadc_hash(&it->kvalue, pvalue);
+        util::kadc_meta(&it->meta, pvalue.meta());
+    }
+
+    _client    = n;
+    _msg_queue = q;
+    _kcc       = kcc;
+    _notify    = h;
+    n->store_defaults(&_params);
+    priority(_params.priority);
+    _admission = n->kadc_admission();
+    _failed    = 0;
+}
+
+task_store_many::~task_store_many() {
+}
+
+void
+task_store_many::_publish(item *it) {
+    auto_ptr<message_store> 
+      msg_i(new message_store(this, client::msg_store_item));
+    msg_i->handler(_notify);
+    msg_i->store_key(&it->skey);
+    msg_i->store_value(&it->svalue);
+    
+    size_t threads   = _params.threads;
+    size_t duration  = _params.duration;   
+    // KadC_republish does not set the defaults, see task_store
+    if (threads == 0)  threads = 5;
+    if (duration == 0) duration = 15;
+
+    char kindex[key128::kadc_index_size];
+    char kvalue[key128::kadc_index_size];
+    it->index.kadc_index(kindex);
+    it->kvalue.kadc_index(kvalue);
+
+    // Each pair is admitted separately, like the calls of store()
+    int kcs = -2;
+    admission::result adm = admission::call_aborted;
+    if (!this->quit())
+        adm = _admission->acquire(this, &threads, time_value_type::zero);
+    if (adm == admission::call_rejected) {
+        kcs = -4;
+    } else if (adm == admission::call_admitted) {
+        kcs = KadC_republish(_kcc, 
+                             kindex, 
+                             kvalue, 
+                             it->meta.c_str(),
+                             threads, duration);
+        _admission->release(threads);
+    }
+    
+    if (kcs == -2) {
+        msg_i->success(false);
+        msg_i->code(0);
+        msg_i->string("Publishing aborted");
+    } else if (kcs == -4) {
+        msg_i->success(false);
+        msg_i->code(client::error_rejected);
+        msg_i->string("Publishing rejected, too many KadC calls running");
+    } else if (kcs == -1) {
+        msg_i->success(false);
+        msg_i->code(0);
+        msg_i->string("error publishing");
+    } else if (kcs == 0) {  
+        msg_i->success(false);
+        msg_i->code(0);
+        msg_i->string("0 nodes accepted the stored key/value");
+    } else {
+        msg_i->success(true);
+        msg_i->replicas(kcs);
+        if (_client->find_cache()) _client->find_cache()->erase(it->index);
+    }
+    if (!msg_i->success()) atomic::add(&_failed, 1UL);
+    
+    _msg_queue->push(msg_i.release());
+    _msg_queue->signal();
+}
+
+void
+task_store_many::work(size_t i) {
+    _publish(&_items[i]);
+}
+
+int 
+task_store_many::svc(void) {
+    ACE_TRACE("task_store_many::svc");
+    auto_ptr<message> msg_p(new message(this, client::msg_store));
+    auto_ptr<message> msg_e(new message(this, client::msg_task_exit));
+    
+    msg_p->handler(_notify);
+    
+    ACE_DEBUG((LM_DEBUG, "task_store_many: stored %d items with %d "
+                         "parts\n", _items.size(), parts()));
+
+    if (atomic::load(&_failed) == 0) {
+        msg_p->success(true);
+    } else {
+        ACE_DEBUG((LM_DEBUG, "task_store_many: %d of %d items failed\n",
+                   _failed, _items.size()));
+        msg_p->success(false);
+        msg_p->code(0);
+        msg_p->string("storing one or more key/value pairs failed");
+    }
+    
+    _msg_queue->push(msg_p.release());
+    _msg_queue->push(msg_e.release());
+    _msg_queue->signal();
+
+    ACE_DEBUG((LM_DEBUG, "task_store_many: done\n"));
+    
+    return 0;
+}
+
+} // ns kadc
+} // ns dht
@@ -0,0 +1,57 @@
+#ifndef DHT_KADC_TASK_STORE_MANY_H_
+#define DHT_KADC_TASK_STORE_MANY_H_
+
+#include <string>
+#include <vector>
+
+#include "task_parts.h"
+#include "client.h"
+#include "key128.h"
+
+namespace dht {
+namespace kadc {
+    // Stores a batch of key/value pairs. The pairs are published by
+    // parts run by the task pool like other stores, each running one
+    // KadC_republish at a time.
+    class task_store_many : public task_parts {
+        struct item {
+            key         skey;
+            value       svalue;
+            key128      index;
+            key128      kvalue;
+            std::string meta;
+        };
+        typedef std::vector<item> items_type;
+        
+        client                     *_client;
+        client::message_queue_type *_msg_queue;
+        items_type      _items;
+        notify_handler *_notify;
+        KadCcontext    *_kcc;
+        store_params    _params;
+        admission      *_admission;
+        
+        // Number of failed items, updated atomically by the parts
+        volatile unsigned long _failed;
+        
+        void _publish(item *it);
+    protected:
+        virtual void work(size_t i);
+    public:
+        task_store_many(client *n,
+                        client::message_queue_type *q,
+                        KadCcontext                *kcc,
+                        const client::key_value    *begin,
+                        const client::key_value    *end,
+                        notify_handler             *h);
+
+        virtual ~task_store_many();
+
+        // Sends the result of the whole batch, run by the last part
+        virtual int svc(void);
+    };
+
+} // ns kadc
+} // ns dht
+
+#endif //DHT_KADC_TASK_STORE_MANY_H_
@@ -1,17 +1,19 @@
 #include <ace/Log_Msg.h>
+#include <ace/OS_NS_sys_time.h>
 
 #include <assert.h>
 #include <string.h>
 
+#include <algorithm>
+
 #include "util.h"
 
 namespace dht {
 namespace kadc {
 namespace util {
 
-void kadc_hash(std::string *result, const void *data, int len, bool do_md4) {
-    unsigned char h[16];
-    char kadch[33]; // 32 + NULL
+void kadc_hash(key128 *result, const void *data, int len, bool do_md4) {
+    unsigned char *h = result->data();
     
     if (do_md4) {
         // ACE_DEBUG((LM_DEBUG, "kadc::kadc_hash creating md4 of the data '%s'\n",
@@ -24,11 +26,25 @@ void kadc_hash(std::string *result, const void *data, int len, bool do_md4) {
         memset(h, 0, 16);
         memcpy(h, data, len);
     }
+}
+
+void kadc_hash(key128 *result, const store_data &d) {
+    if (!d.allow_hash_transform()) {
+        kadc_hash(result, d.data(), d.size(), false);
+    } else if (!d.cached_digest(result->data())) {
+        kadc_hash(result, d.data(), d.size(), true);
+        d.cache_digest(result->data());
+    }
+}
+
+void kadc_hash(std::string *result, const void *data, int len, bool do_md4) {
+    key128 h;
+    kadc_hash(&h, data, len, do_md4);
     
     // Create kadc style hash
-    int128sprintf(kadch, h);
-    *result  = "#";
-    *result += kadch;
+    char kadch[key128::kadc_index_size];
+    h.kadc_index(kadch);
+    *result = kadch;
     
     ACE_DEBUG((LM_DEBUG, "kadc::kadc_hash created hash %s\n", result->c_str()));
 }
@@ -38,9 +54,9 @@ void kadc_meta(std::string *result, const name_value_map &meta) {
     name_value_map::const_iterator i = meta.begin();
     for (; i != meta.end(); i++) {
         if (!result->empty()) *result += ";";
-        *result += i->first;
+        result->append(i->first.data(), i->first.size());
         *result += "=";
-        *result += i->second;
+        result->append(i->second.data(), i->second.size());
     }
     ACE_DEBUG((LM_DEBUG, "kadc::kadc_meta created metalist %s\n", 
               result->c_str()));    
@@ -81,6 +97,23 @@ void kadc_result(value *v, KadCdictionary *pkd) {
     }
 }
 
+void kadc_result_raw(std::string *raw, KadCdictionary *pkd) {
+    KadCtag_iter iter;
+    unsigned int i;
+    
+    KadCtag_begin(pkd, &iter);
+    raw->append((const char *)iter.vhash, 16);
+    
+    // Only string tags are supported, like in kadc_result()
+    for(i = 0; i < iter.tagsleft; i++, KadCtag_next(&iter)) {
+        if (iter.tagtype != KADCTAG_STRING) continue;
+        raw->append(iter.tagname);
+        raw->push_back('\0');
+        raw->append(iter.tagvalue);
+        raw->push_back('\0');
+    }
+}
+
 void kadc_free_search_result(void *resdictrbt) {
     KadCdictionary *pkd;
     void *iter;
@@ -104,6 +137,19 @@ void kadc_external_address(addr_inet_type *a, KadCcontext *pkcc) {
               a->get_host_addr(), a->get_port_number()));             
 }
 
+bool kadc_duration(size_t *duration, const time_value_type &deadline) {
+    if (deadline == time_value_type::zero) return true;
+    
+    time_value_type left = deadline - ACE_OS::gettimeofday();
+    if (left <= time_value_type::zero) return false;
+    
+    // KadC counts whole seconds. The part of a second is dropped, 
+    // but at least one second is given.
+    size_t secs = std::max<size_t>(left.sec(), 1);
+    if (*duration == 0 || *duration > secs) *duration = secs;
+    return true;
+}
+
 } // ns util
 } // ns kadc
 } // ns dht
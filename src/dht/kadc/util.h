@@ -5,17 +5,29 @@
 
 #include "../name_value_map.h"
 #include "../value.h"
+#include "../store_data.h"
 #include "client.h"
+#include "key128.h"
 
 namespace dht {
 namespace kadc {
 namespace util {
 
+void kadc_hash(key128 *result, const void *data, int len, bool do_md4);
+// Uses and fills the digest cached in the store_data
+void kadc_hash(key128 *result, const store_data &d);
 void kadc_hash(std::string *result, const void *data, int len, bool do_md4);
 void kadc_meta(std::string *result, const name_value_map &meta);
 void kadc_result(value *v, KadCdictionary *pkd);
+// Appends the value hash and the string tags of the result to raw,
+// see message_search_view
+void kadc_result_raw(std::string *raw, KadCdictionary *pkd);
 void kadc_free_search_result(void *resdictrbt);
 void kadc_external_address(addr_inet_type *result, KadCcontext *pkcc);
+// Shortens duration (seconds, 0 for KadC's default) so that an 
+// operation started now ends by deadline. Returns false if the 
+// deadline has passed. A zero deadline leaves duration as it is.
+bool kadc_duration(size_t *duration, const time_value_type &deadline);
 
 } // ns util
 } // ns kadc
@@ -45,6 +45,14 @@ namespace dht {
          */
         inline key(const std::string &str, bool aht = true);
         virtual ~key();
+        
+        /**
+         * @brief Exchanges the contents with another key
+         * 
+         * Moves a key without copying its data, see 
+         * client::find_move().
+         */
+        inline void swap(key &o) { store_data::swap(o); }
     };
 
     inline key::key() 
@@ -1,16 +1,49 @@
+#include <string.h>
+
 #include "name_value_map.h"
 
 using namespace std;
 
 namespace dht {
 
+// Names are looked up with C strings and their lengths
+static inline int
+compare(const string &name, const char *key, size_t len) {
+    return name.compare(0, string::npos, key, len);
+}
+
 name_value_map::name_value_map() {}
 
 name_value_map::~name_value_map() {}
 
+name_value_map::const_iterator
+name_value_map::_lower_bound(const char *key, size_t len) const {
+    // Binary search, the vector is sorted by the names
+    const_iterator first = _str_map.begin();
+    size_t         n     = _str_map.size();
+    while (n > 0) {
+        size_t         half = n / 2;
+        const_iterator mid  = first + half;
+        if (compare(mid->first, key, len) < 0) {
+            first = mid + 1;
+            n    -= half + 1;
+        } else {
+            n     = half;
+        }
+    }
+    return first;
+}
+
+name_value_map::const_iterator
+name_value_map::_find(const char *key, size_t len) const {
+    const_iterator i = _lower_bound(key, len);
+    if (i != _str_map.end() && compare(i->first, key, len) == 0) return i;
+    return _str_map.end();
+}
+
 const string &
 name_value_map::get(const string &key) const {
-    container_type::const_iterator i = _str_map.find(key);
+    const_iterator i = _find(key.data(), key.size());
     
     if (i == _str_map.end()) {
         throw call_errorf(
@@ -24,26 +57,68 @@ name_value_map::get(const string &key) const {
 
 const string &
 name_value_map::get(const string &key, const string &def) const {
-    container_type::const_iterator i = _str_map.find(key);
+    const_iterator i = _find(key.data(), key.size());
 
     return (i == _str_map.end() ? def : i->second);
 }
 
 void
-name_value_map::set(const string &key, const string &value,
-                    bool error_if_set)
+name_value_map::_set(const char *key,   size_t key_len, 
+                     const char *value, size_t value_len,
+                     bool error_if_set)
 {
-    container_type::const_iterator i = _str_map.find(key);
+    size_t pos = _lower_bound(key, key_len) - _str_map.begin();
     
-    if (error_if_set && i != _str_map.end()) {
-        throw call_errorf(
-            "option %s already set with value " \
-            "%s, tried setting it to %s",
-            key.c_str(), i->second.c_str(), value.c_str()
-        );
+    if (pos < _str_map.size() && 
+        compare(_str_map[pos].first, key, key_len) == 0) 
+    {
+        if (error_if_set) {
+            throw call_errorf(
+                "option %s already set with value " \
+                "%s, tried setting it to %s",
+                key, _str_map[pos].second.c_str(), value
+            );
+        }
+        _str_map[pos].second.assign(value, value_len);
+        return;
     }
     
-    _str_map[key] = value;
+    if (_str_map.size() == _str_map.capacity()) {
+        // Grown here instead of by push_back(), which would copy the
+        // strings to the new block. The entries are swapped to their
+        // places, leaving the position empty. Meta data usually has a
+        // few names, so the first block has room for 4.
+        container_type grown;
+        grown.reserve(_str_map.empty() ? 4 : _str_map.size() * 2);
+        grown.resize(_str_map.size() + 1);
+        for (size_t i = 0; i < _str_map.size(); i++) {
+            size_t j = (i < pos ? i : i + 1);
+            grown[j].first.swap(_str_map[i].first);
+            grown[j].second.swap(_str_map[i].second);
+        }
+        _str_map.swap(grown);
+    } else {
+        // Entries after the position are moved by swapping
+        _str_map.push_back(value_type());
+        for (size_t i = _str_map.size() - 1; i > pos; i--) {
+            _str_map[i].first.swap(_str_map[i - 1].first);
+            _str_map[i].second.swap(_str_map[i - 1].second);
+        }
+    }
+    _str_map[pos].first.assign(key, key_len);
+    _str_map[pos].second.assign(value, value_len);
+}
+
+void
+name_value_map::set(const string &key, const string &value,
+                    bool error_if_set)
+{
+    _set(key.c_str(), key.size(), value.c_str(), value.size(), error_if_set);
+}
+
+void
+name_value_map::set(const char *key, const char *value, bool error_if_set) {
+    _set(key, strlen(key), value, strlen(value), error_if_set);
 }
 
 } // ns dht
@@ -1,8 +1,9 @@
 #ifndef DHT_NAME_VALUE_MAP_H_
 #define DHT_NAME_VALUE_MAP_H_
 
-#include <map>
 #include <string>
+#include <utility>
+#include <vector>
 #include "exception.h"
 
 namespace dht {
@@ -16,16 +17,41 @@ namespace dht {
      * only one value exists.
      * 
      * Stl style iterator is provided for going through all the
-     * name/value pairs contained within.
+     * name/value pairs contained within, in the order of the names.
+     * 
+     * Meta data of values usually has only a few names, so the pairs
+     * are kept in a sorted vector instead of a tree. Setting a new 
+     * name invalidates iterators and references obtained from the
+     * object.
+     * 
+     * The names and values are std::strings, so that get() can 
+     * return references to them and iterators yield pairs of 
+     * strings as before. They are not kept in inline buffers of their
+     * own: a string longer than the library's short string buffer
+     * (none with copy-on-write strings) is still allocated.
+     * 
+     * iterator is the same type as const_iterator and there is no
+     * non-const begin() or end(), so code that modified the pairs
+     * through iterators no longer compiles.
      */
     class name_value_map {
     public:
-        typedef std::map<std::string, std::string>            container_type;
-        typedef container_type::iterator       iterator;
+        typedef std::pair<std::string, std::string> value_type;
+        typedef std::vector<value_type>             container_type;
+        // The order of the names must be kept, so the pairs can not
+        // be modified through iterators
         typedef container_type::const_iterator const_iterator;
+        typedef const_iterator                 iterator;
                 
     private:
         container_type _str_map;
+        
+        // First entry with a name not less than the given one
+        const_iterator _lower_bound(const char *key, size_t len) const;
+        const_iterator _find(const char *key, size_t len) const;
+        void           _set(const char *key,   size_t key_len, 
+                            const char *value, size_t value_len,
+                            bool error_if_set);
     public:
         name_value_map();
         
@@ -54,7 +80,8 @@ namespace dht {
          *             specified here.
          * @return  a reference to the value.
          */     
-        const std::string &get(const std::string &key, const std::string &def) const;
+        const std::string &get(const std::string &key, 
+                               const std::string &def) const;
 
         /**
          * @brief Sets the value
@@ -65,6 +92,14 @@ namespace dht {
          */     
         void        set(const std::string &key, const std::string &value, 
                         bool error_if_set = false);
+        /**
+         * @brief Sets the value from C strings
+         * 
+         * Same as the std::string version, but does not create 
+         * temporary strings.
+         */
+        void        set(const char *key, const char *value, 
+                        bool error_if_set = false);
 
         /**
          * @brief Checks if the key exists
@@ -73,17 +108,15 @@ namespace dht {
         inline bool exists(const std::string &key) const;
         
         /**
-         * @brief stl style iterator accessors 
+         * @brief Exchanges the contents with another map without
+         *        copying them
          */
-        inline iterator       begin();
+        inline void swap(name_value_map &o);
+        
         /**
          * @brief stl style iterator accessors 
          */
         inline const_iterator begin() const;
-        /**
-         * @brief stl style iterator accessors 
-         */
-        inline iterator       end();
         /**
          * @brief stl style iterator accessors 
          */
@@ -92,18 +125,15 @@ namespace dht {
 
     inline bool
     name_value_map::exists(const std::string &key) const {
-        return _str_map.find(key) != _str_map.end() ? true : false;
+        return _find(key.data(), key.size()) != _str_map.end();
     }
     
-    inline name_value_map::iterator 
-    name_value_map::begin() { return _str_map.begin(); }
+    inline void
+    name_value_map::swap(name_value_map &o) { _str_map.swap(o._str_map); }
     
     inline name_value_map::const_iterator 
     name_value_map::begin() const { return _str_map.begin(); }
 
-    inline name_value_map::iterator 
-    name_value_map::end() { return _str_map.end(); }
-
     inline name_value_map::const_iterator 
     name_value_map::end() const { return _str_map.end(); }  
 } // namespace dht
@@ -4,6 +4,25 @@ namespace dht {
 
 search_handler::~search_handler() {}
 
+int
+search_handler::found_batch(const dht::key   &k,
+                            const dht::value *begin,
+                            const dht::value *end)
+{
+    for (; begin != end; begin++) {
+        int ret = found(k, *begin);
+        if (ret) return ret;
+    }
+    return 0;
+}
+
+int
+search_handler::found_view(const dht::key &k, const dht::value_view &v) {
+    value copy;
+    v.copy(&copy);
+    return found(k, copy);
+}
+
 void 
 search_handler::success(const dht::key &) { success(); }
 
@@ -12,6 +31,9 @@ search_handler::failure(const dht::key &, int error, const char *errstr) {
     failure(error, errstr); 
 }
 
+void 
+search_handler::finished() {}
+
 void 
 search_handler::success() {}
 
@@ -4,6 +4,7 @@
 #include "notify_handler.h"
 #include "key.h"
 #include "value.h"
+#include "value_view.h"
 
 namespace dht {
     /**
@@ -28,12 +29,45 @@ namespace dht {
          * then no more search results for the search operation
          * are returned. If 0 returned, operation continues as normal.
          * Notice that if non-zero is returned, the success() and
-         * failure() routines will NOT be called.
+         * failure() routines will NOT be called. Implementations
+         * may end the search itself once nobody wants its results.
          * 
          * The return value from this overrides any return value
          * that might have been returned by an observer.
          */
         virtual int found(const dht::key &k, const dht::value &v) = 0;
+
+        /**
+         * @brief Called when several search results have been obtained
+         *        at once.
+         * @param k      The key that was searched
+         * @param begin  Pointer to the first value obtained
+         * @param end    Pointer past the last value obtained
+         * 
+         * Implementations that deliver results in batches call this
+         * instead of found(). The default implementation calls found()
+         * for each value until found() returns non-zero. The return value
+         * has the same meaning as in found().
+         */
+        virtual int found_batch(const dht::key   &k,
+                                const dht::value *begin,
+                                const dht::value *end);
+        /**
+         * @brief Called with a view of a search result
+         * @param k  The key that was searched
+         * @param v  A view of the value, valid only during this call
+         * 
+         * Implementations that deliver results as views call this
+         * instead of found(), for example the KadC client when its 
+         * find_view option is set. Handlers that read only part of 
+         * the result or drop most results can override this to avoid
+         * copying them. The default implementation copies the view 
+         * to a value and calls found(). The return value has the same
+         * meaning as in found().
+         * 
+         * @see value_view
+         */
+        virtual int found_view(const dht::key &k, const dht::value_view &v);
         
         /**
          * @brief  Called if search finished successfully
@@ -54,6 +88,16 @@ namespace dht {
         virtual void failure(const dht::key &k, 
                              int error, const char *errstr);
         
+        /**
+         * @brief Called when every search started by one 
+         *        client::find_many() call has finished
+         * 
+         * success() or failure() has been called before this for 
+         * each key, except for the keys for which found() 
+         * returned non-zero. The default implementation does nothing.
+         */
+        virtual void finished();
+        
         virtual void success();
         virtual void failure(int error, const char *errstr);
     };
@@ -0,0 +1,489 @@
+#include <ace/OS_NS_stdlib.h>
+
+#include <stdlib.h>
+
+#include <algorithm>
+
+#include "../exception.h"
+#include "../notify_handler.h"
+#include "../search_handler.h"
+#include "client.h"
+#include "timer_handler.h"
+
+using namespace std;
+
+namespace dht {
+namespace sim {
+
+static void
+opt_msec(const name_value_map &opts, const char *name, time_value_type *t) {
+    if (!opts.exists(name)) return;
+    t->msec(strtol(opts.get(name).c_str(), NULL, 10));
+}
+
+client::client() {
+    _network   = network::instance();
+    _reactor   = reactor_type::instance();
+    _theandler = new timer_handler(this);
+    _delivering       = NULL;
+    _delivery_aborted = false;
+    _ext_addr.set((u_short)0, "127.0.0.1");
+    
+    _latency         = time_value_type(0, 50 * 1000);
+    _latency_jitter  = time_value_type(0, 0);
+    _connect_latency = time_value_type(0, 100 * 1000);
+    _hit_interval    = time_value_type(0, 0);
+    _max_hits        = 500;
+    _store_many_threads = 4;
+    _find_many_threads  = 4;
+    _failure_rate    = 0.0;
+    _seed            = 1;
+}
+
+client::~client() {
+    ACE_DEBUG((LM_DEBUG, "dht::sim::client: dtor called\n"));
+    _reactor->cancel_timer(_theandler);
+    operations_type::iterator i = _ops.begin();
+    for (; i != _ops.end(); i++) delete *i;
+    _ops.clear();
+    delete _theandler;
+}
+
+void
+client::init(const name_value_map &opts) {
+    ACE_DEBUG((LM_DEBUG, "sim::init called\n"));
+    opt_msec(opts, "latency",         &_latency);
+    opt_msec(opts, "latency_jitter",  &_latency_jitter);
+    opt_msec(opts, "connect_latency", &_connect_latency);
+    opt_msec(opts, "hit_interval",    &_hit_interval);
+    if (opts.exists("max_hits")) {
+        _max_hits = strtoul(opts.get("max_hits").c_str(), NULL, 10);
+    }
+    if (opts.exists("store_many_threads")) {
+        _store_many_threads = 
+            strtoul(opts.get("store_many_threads").c_str(), NULL, 10);
+        if (_store_many_threads == 0) _store_many_threads = 1;
+    }
+    if (opts.exists("find_many_threads")) {
+        _find_many_threads = 
+            strtoul(opts.get("find_many_threads").c_str(), NULL, 10);
+        if (_find_many_threads == 0) _find_many_threads = 1;
+    }
+    if (opts.exists("failure_rate")) {
+        _failure_rate = strtod(opts.get("failure_rate").c_str(), NULL);
+        if (_failure_rate < 0.0 || _failure_rate > 1.0) {
+            throw call_errorf("dht::sim::init failure_rate %s not in [0, 1]",
+                              opts.get("failure_rate").c_str());
+        }
+    }
+    if (opts.exists("seed")) {
+        _seed = (unsigned int)strtoul(opts.get("seed").c_str(), NULL, 10);
+    }
+}
+
+void
+client::connect(notify_handler *handler) {
+    ACE_DEBUG((LM_DEBUG, "sim::connect called\n"));
+    if (in_state() != disconnected) {
+        throw call_errorf("dht::sim::connect not disconnected, "
+                          "current state '%s'", in_state_str());
+    }
+    _start(op_connect, handler, _connect_latency);
+    _change_state(connecting);
+}
+
+void
+client::disconnect(notify_handler *handler) {
+    ACE_DEBUG((LM_DEBUG, "sim::disconnect called\n"));
+    if (in_state() == disconnected || in_state() == disconnecting) {
+        throw call_errorf("dht::sim::disconnect already '%s'", 
+                          in_state_str());
+    }
+    // Connecting or searching is aborted right away, like the
+    // KadC implementation does
+    _abort_all("Aborted by disconnect");
+    _start(op_disconnect, handler, _connect_latency);
+    _change_state(disconnecting);
+}
+
+void
+client::find(const key &fkey, search_handler *handler) {
+    ACE_DEBUG((LM_DEBUG, "sim::find called\n"));
+    if (in_state() != connected) {
+        throw call_errorf("dht::sim::find not connected, current state '%s'",
+                          in_state_str());
+    }
+    operation *op = _start(op_find, handler, _delay(_latency));
+    op->okey = fkey;
+}
+
+void
+client::find_many(const key *begin, const key *end, search_handler *handler) {
+    ACE_DEBUG((LM_DEBUG, "sim::find_many called\n"));
+    if (in_state() != connected) {
+        throw call_errorf("dht::sim::find_many not connected, "
+                          "current state '%s'", in_state_str());
+    }
+    operation *op = _start(op_find_many, handler, _delay(_latency));
+    op->keys.assign(begin, end);
+}
+
+void
+client::store(const key &skey, const value &svalue, notify_handler *handler) {
+    ACE_DEBUG((LM_DEBUG, "sim::store called\n"));
+    if (in_state() != connected) {
+        throw call_errorf("dht::sim::store not connected, current state '%s'",
+                          in_state_str());
+    }
+    operation *op = _start(op_store, handler, _delay(_latency));
+    op->okey   = skey;
+    op->ovalue = svalue;
+}
+
+void
+client::store_many(const key_value    *begin, 
+                   const key_value    *end,
+                   store_many_handler *handler) 
+{
+    ACE_DEBUG((LM_DEBUG, "sim::store_many called\n"));
+    if (in_state() != connected) {
+        throw call_errorf("dht::sim::store_many not connected, "
+                          "current state '%s'", in_state_str());
+    }
+    operation *op = _start(op_store_many, handler, _delay(_latency));
+    op->items.assign(begin, end);
+}
+
+const addr_inet_type &
+client::external_addr() {
+    return _ext_addr;
+}
+
+int
+client::process(time_value_type &max_wait) {
+    return _reactor->handle_events(max_wait);
+}
+
+int
+client::process(time_value_type *max_wait) {
+    return _reactor->handle_events(max_wait);
+}
+
+reactor_type *
+client::reactor() {
+    return _reactor;
+}
+
+void
+client::reactor(reactor_type *r) {
+    if (r == NULL) {
+        throw call_error("dht::sim::reactor NULL pointer not allowed");
+    }
+    if (!_ops.empty()) {
+        throw call_error("dht::sim::reactor can not be changed while "
+                         "operations are pending");
+    }
+    _reactor = r;
+}
+
+int
+client::handler_cancel(notify_handler *handler) {
+    int counter = 0;
+    operations_type::iterator i = _ops.begin();
+    for (; i != _ops.end(); i++) {
+        if ((*i)->handler == handler) {
+            (*i)->handler = NULL;
+            counter++;
+        }
+    }
+    return counter;
+}
+
+void
+client::sim_network(network *n) {
+    if (n == NULL) {
+        throw call_error("dht::sim::sim_network NULL pointer not allowed");
+    }
+    if (!_ops.empty()) {
+        throw call_error("dht::sim::sim_network can not be changed while "
+                         "operations are pending");
+    }
+    _network = n;
+}
+
+void
+client::_change_state(int s) {
+    ACE_DEBUG((LM_DEBUG, "sim::change_state new state %s\n", state_str(s)));
+    observer_notifier()->state_changed(s);
+}
+
+time_value_type
+client::_delay(const time_value_type &base) {
+    if (_latency_jitter == time_value_type::zero) return base;
+    double r = (double)ACE_OS::rand_r(&_seed) / ((double)RAND_MAX + 1.0);
+    time_value_type d;
+    d.msec(base.msec() + (long)(r * _latency_jitter.msec()));
+    return d;
+}
+
+bool
+client::_fails() {
+    if (_failure_rate <= 0.0) return false;
+    double r = (double)ACE_OS::rand_r(&_seed) / ((double)RAND_MAX + 1.0);
+    return r < _failure_rate;
+}
+
+client::operation *
+client::_start(int type, notify_handler *h, const time_value_type &delay) {
+    operation *op   = new operation;
+    op->type        = type;
+    op->handler     = h;
+    op->fetched     = false;
+    op->next_result = 0;
+    op->failed_items = 0;
+    op->timer_id    = -1;
+    try {
+        _schedule(op, delay);
+    } catch (...) {
+        delete op;
+        throw;
+    }
+    _ops.insert(op);
+    return op;
+}
+
+void
+client::_schedule(operation *op, const time_value_type &delay) {
+    op->timer_id = _reactor->schedule_timer(_theandler, op, delay);
+    if (op->timer_id == -1) {
+        throw operation_error("dht::sim could not schedule a timer");
+    }
+}
+
+void
+client::_finish(operation *op) {
+    if (op == _delivering) _delivering = NULL;
+    _ops.erase(op);
+    delete op;
+}
+
+void
+client::_abort_all(const char *reason) {
+    // Handlers may start new operations, so the pending ones are 
+    // taken out before any handler is called
+    operations_type aborted;
+    aborted.swap(_ops);
+    
+    operations_type::iterator i = aborted.begin();
+    for (; i != aborted.end(); i++) {
+        _reactor->cancel_timer((*i)->timer_id);
+    }
+    for (i = aborted.begin(); i != aborted.end(); i++) {
+        operation *op = *i;
+        if (op->handler) {
+            if (op->type == op_find || op->type == op_find_many) {
+                static_cast<search_handler *>(op->handler)->failure(
+                    op->okey, 0, reason);
+            } else {
+                op->handler->failure(0, reason);
+            }
+        }
+        // The delivery that called disconnect() still uses it
+        if (op == _delivering) _delivery_aborted = true;
+        else                   delete op;
+    }
+}
+
+void
+client::_timeout(const void *act) {
+    operation *op = static_cast<operation *>(const_cast<void *>(act));
+    if (_ops.find(op) == _ops.end()) {
+        ACE_DEBUG((LM_DEBUG, "sim::_timeout unknown operation\n"));
+        return;
+    }
+    op->timer_id = -1;
+    
+    _delivering       = op;
+    _delivery_aborted = false;
+    try {
+        _deliver(op);
+    } catch (...) {
+        _delivered(op);
+        throw;
+    }
+    _delivered(op);
+}
+
+void
+client::_delivered(operation *op) {
+    if (_delivery_aborted) delete op;
+    _delivering       = NULL;
+    _delivery_aborted = false;
+}
+
+void
+client::_deliver(operation *op) {
+    notify_handler *h = op->handler;
+    
+    switch (op->type) {
+    case op_connect:
+        _finish(op);
+        _change_state(connected);
+        if (h) h->success();
+        break;
+    case op_disconnect:
+        _finish(op);
+        _change_state(disconnected);
+        if (h) h->success();
+        break;
+    case op_store:
+        if (_fails()) {
+            _finish(op);
+            if (h) h->failure(0, "Simulated store failure");
+            break;
+        }
+        _network->store(op->okey, op->ovalue);
+        _finish(op);
+        if (h) h->success();
+        break;
+    case op_store_many:
+        _store_many_next(op);
+        break;
+    case op_find_many:
+        _find_many_next(op);
+        break;
+    case op_find:
+        if (!op->fetched && _fails()) {
+            key k(op->okey);
+            _finish(op);
+            if (h) static_cast<search_handler *>(h)->failure(
+                       k, 0, "Simulated search failure");
+            break;
+        }
+        _find_next(op);
+        break;
+    default:
+        _finish(op);
+        throw unexpected_errorf("dht::sim unknown operation type %d", 
+                                op->type);
+    }
+}
+
+void
+client::_find_next(operation *op) {
+    if (!op->fetched) {
+        _network->find(op->okey, &op->results, _max_hits);
+        op->fetched = true;
+    }
+    
+    while (op->next_result < op->results.size()) {
+        const value &v = op->results[op->next_result++];
+        
+        int obs_ret = observer_notifier()->search_result(op->okey, v);
+        // Handlers and observers may disconnect, which aborts the
+        // operation
+        if (_delivery_aborted) return;
+        // Only find() starts searches, so the handler is a search_handler.
+        // It is read after the observer in case handler_cancel was called.
+        search_handler *h = static_cast<search_handler *>(op->handler);
+        // Non-zero return value stops the search without calling 
+        // success() or failure()
+        int stop = (h ? h->found(op->okey, v) : obs_ret);
+        if (_delivery_aborted) return;
+        if (stop) {
+            _finish(op);
+            return;
+        }
+        
+        if (op->next_result < op->results.size() && 
+            _hit_interval != time_value_type::zero)
+        {
+            _schedule(op, _hit_interval);
+            return;
+        }
+    }
+    
+    key k(op->okey);
+    search_handler *h = static_cast<search_handler *>(op->handler);
+    _finish(op);
+    if (h) h->success(k);
+}
+
+void
+client::_store_many_next(operation *op) {
+    // Stores the pairs that would finish during one latency period
+    size_t n = std::min(op->items.size() - op->next_result, 
+                        _store_many_threads);
+    for (; n > 0; n--) {
+        const key_value &kv = op->items[op->next_result++];
+        // Handler is read each time in case handler_cancel was called
+        store_many_handler *h = static_cast<store_many_handler *>(op->handler);
+        if (_fails()) {
+            op->failed_items++;
+            if (h) h->store_failed(kv.first, kv.second, 0, 
+                                   "Simulated store failure");
+        } else {
+            _network->store(kv.first, kv.second);
+            if (h) h->stored(kv.first, kv.second, 1);
+        }
+        // The handler may have disconnected
+        if (_delivery_aborted) return;
+    }
+    
+    if (op->next_result < op->items.size()) {
+        _schedule(op, _delay(_latency));
+        return;
+    }
+    
+    notify_handler *h = op->handler;
+    bool failed = op->failed_items > 0;
+    _finish(op);
+    if (h && failed) h->failure(0, "storing one or more key/value pairs "
+                                   "failed");
+    else if (h)      h->success();
+}
+
+void
+client::_find_many_next(operation *op) {
+    // Searches the keys that would finish during one latency period.
+    // Hit interval is not simulated for find_many.
+    size_t n = std::min(op->keys.size() - op->next_result, 
+                        _find_many_threads);
+    for (; n > 0; n--) {
+        const key &k = op->keys[op->next_result++];
+        // Handler is read each time in case handler_cancel was called
+        if (_fails()) {
+            search_handler *h = static_cast<search_handler *>(op->handler);
+            if (h) h->failure(k, 0, "Simulated search failure");
+            if (_delivery_aborted) return;
+            continue;
+        }
+        
+        std::vector<value> values;
+        _network->find(k, &values, _max_hits);
+        bool stopped = false;
+        for (size_t i = 0; i < values.size() && !stopped; i++) {
+            int obs_ret = observer_notifier()->search_result(k, values[i]);
+            // The handler or observer may have disconnected
+            if (_delivery_aborted) return;
+            search_handler *h = static_cast<search_handler *>(op->handler);
+            stopped = h ? h->found(k, values[i]) != 0 : obs_ret != 0;
+            if (_delivery_aborted) return;
+        }
+        search_handler *h = static_cast<search_handler *>(op->handler);
+        if (h && !stopped) h->success(k);
+        if (_delivery_aborted) return;
+    }
+    
+    if (op->next_result < op->keys.size()) {
+        _schedule(op, _delay(_latency));
+        return;
+    }
+    
+    search_handler *h = static_cast<search_handler *>(op->handler);
+    _finish(op);
+    if (h) h->finished();
+}
+
+} // ns sim
+} // ns dht
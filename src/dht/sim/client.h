@@ -0,0 +1,192 @@
+#ifndef DHT_SIM_CLIENT_H_
+#define DHT_SIM_CLIENT_H_
+
+#include <set>
+#include <vector>
+
+#include "../client.h"
+#include "network.h"
+
+namespace dht {
+namespace sim {
+    /**
+     * @class client client.h dht/sim/client.h
+     * @brief Simulated DHT that keeps the key/value pairs in memory
+     * 
+     * This implementation of dht::client interface does not use any
+     * network. Values are stored to and found from a sim::network 
+     * object that can be shared by several clients. The latency, 
+     * number of hits and failure rate of operations are configurable,
+     * which makes the implementation useful for benchmarking and
+     * testing applications without a live DHT.
+     * 
+     * Each operation completes after the configured latency from a
+     * reactor timer, so handlers and observers are called from 
+     * process() or the reactor loop like with other implementations.
+     * 
+     * A little code snippet example:
+     * 
+     * @code
+     * #include <dht/sim/client.h>
+     * 
+     * int main() {
+     *    dht::sim::client client;
+     *    dht::name_value_map conf;
+     * 
+     *    conf.set("latency", "200");
+     *    conf.set("failure_rate", "0.01");
+     *    client.init(conf);
+     *    do_stuff(client);
+     *    return 0;
+     * }
+     * @endcode
+     * 
+     * @see network
+     */
+    class client : public dht::client {
+    public:
+        /// @cond SIM_INTERNAL
+        friend class timer_handler;
+        /// @endcond
+    private:
+        struct operation {
+            int                type;
+            key                okey;
+            value              ovalue;
+            notify_handler    *handler;
+            // Results of find, fetched when first result is due
+            std::vector<value> results;
+            bool               fetched;
+            size_t             next_result;
+            // Pairs of store_many, next_result is the next to store
+            std::vector<key_value> items;
+            // Keys of find_many, next_result is the next to search
+            std::vector<key>   keys;
+            size_t             failed_items;
+            long               timer_id;
+        };
+        typedef std::set<operation *> operations_type;
+        
+        enum {
+            op_connect = 1,
+            op_disconnect,
+            op_find,
+            op_store,
+            op_store_many,
+            op_find_many
+        };
+        
+        network             *_network;
+        reactor_type        *_reactor;
+        class timer_handler *_theandler;
+        addr_inet_type       _ext_addr;
+        operations_type      _ops;
+        // Operation whose handler is being called from _timeout(). If
+        // the handler disconnects, the operation is aborted but not 
+        // deleted until the delivery has returned.
+        operation           *_delivering;
+        bool                 _delivery_aborted;
+        
+        time_value_type _latency,
+                        _latency_jitter,
+                        _connect_latency,
+                        _hit_interval;
+        size_t          _max_hits;
+        size_t          _store_many_threads;
+        size_t          _find_many_threads;
+        double          _failure_rate;
+        unsigned int    _seed;
+        
+        void _change_state(int s);
+        time_value_type _delay(const time_value_type &base);
+        bool _fails();
+        
+        operation *_start(int type, notify_handler *h, 
+                          const time_value_type &delay);
+        void _schedule(operation *op, const time_value_type &delay);
+        void _finish(operation *op);
+        void _abort_all(const char *reason);
+        
+        // Called by timer_handler
+        void _timeout(const void *act);
+        void _deliver(operation *op);
+        void _delivered(operation *op);
+        void _find_next(operation *op);
+        void _store_many_next(operation *op);
+        void _find_many_next(operation *op);
+    public:
+        client();
+        virtual ~client();
+
+        /**
+         * @brief Initialisation of simulation parameters
+         * 
+         * Supported keys in dht::sim::client, times in milliseconds:
+         * - latency: time from find() or store() until the first result 
+         *   or the completion (default 50)
+         * - latency_jitter: random extra time added to latency, between 0 
+         *   and the given value (default 0)
+         * - connect_latency: time it takes to connect and 
+         *   disconnect (default 100)
+         * - hit_interval: time between consecutive results of a find
+         *   (default 0, all results at once)
+         * - max_hits: maximum number of results a find delivers
+         *   (default 500, 0 for unlimited)
+         * - failure_rate: probability between 0.0 and 1.0 that 
+         *   find or store fails (default 0.0)
+         * - store_many_threads: number of pairs store_many() stores
+         *   each latency period (default 4)
+         * - find_many_threads: number of keys find_many() searches
+         *   each latency period (default 4)
+         * - seed: seed for the random numbers (default 1)
+         */
+        virtual void init(const name_value_map &opts);
+        
+        virtual void connect(dht::notify_handler    *handler = NULL);
+        virtual void disconnect(dht::notify_handler *handler = NULL);
+        
+        virtual void find(const dht::key      &fkey,
+                          dht::search_handler *handler);
+
+        virtual void find_many(const dht::key      *begin,
+                               const dht::key      *end,
+                               dht::search_handler *handler);
+
+        virtual void store(const dht::key      &skey,
+                           const dht::value    &svalue,
+                           dht::notify_handler *handler = NULL);
+
+        virtual void store_many(const key_value          *begin,
+                                const key_value          *end,
+                                dht::store_many_handler *handler = NULL);
+
+        virtual const addr_inet_type &external_addr();
+
+        virtual int process(time_value_type &max_wait);
+        virtual int process(time_value_type *max_wait = NULL);
+        virtual reactor_type *reactor();
+        virtual void          reactor(reactor_type *reactor);
+        virtual int handler_cancel(notify_handler *handler);
+        
+        /**
+         * @brief Gets the network the client uses
+         */
+        inline network *sim_network() { return _network; }
+        /**
+         * @brief Sets the network the client uses
+         * @param n the network, by default network::instance()
+         * 
+         * Must not be changed while operations are pending.
+         */
+        void sim_network(network *n);
+        
+        /**
+         * @brief Returns number of operations that are not finished
+         */
+        inline size_t pending_operations() const { return _ops.size(); }
+    };
+        
+} // ns sim
+} // ns dht
+
+#endif //DHT_SIM_CLIENT_H_
@@ -0,0 +1,70 @@
+#include <ace/Guard_T.h>
+
+#include <string.h>
+
+#include "network.h"
+
+namespace dht {
+namespace sim {
+
+network *network::_instance = NULL;
+
+network::network() {}
+
+network::~network() {}
+
+network *
+network::instance() {
+    if (!_instance) _instance = new network;
+    return _instance;
+}
+
+void
+network::store(const key &k, const value &v) {
+    ACE_Guard<ACE_Thread_Mutex> guard(_m);
+    values_type &vs = _store[_index(k)];
+    
+    values_type::iterator i = vs.begin();
+    for (; i != vs.end(); i++) {
+        if (i->size() == v.size() && 
+            memcmp(i->data(), v.data(), v.size()) == 0) 
+        {
+            *i = v;
+            return;
+        }
+    }
+    vs.push_back(v);
+}
+
+size_t
+network::find(const key &k, std::vector<value> *result, 
+              size_t max_hits) const 
+{
+    ACE_Guard<ACE_Thread_Mutex> guard(_m);
+    store_type::const_iterator si = _store.find(_index(k));
+    if (si == _store.end()) return 0;
+    
+    size_t n = 0;
+    values_type::const_iterator i = si->second.begin();
+    for (; i != si->second.end() && (max_hits == 0 || n < max_hits); 
+         i++, n++)
+    {
+        result->push_back(*i);
+    }
+    return n;
+}
+
+size_t
+network::keys() const {
+    ACE_Guard<ACE_Thread_Mutex> guard(_m);
+    return _store.size();
+}
+
+void
+network::clear() {
+    ACE_Guard<ACE_Thread_Mutex> guard(_m);
+    _store.clear();
+}
+
+} // ns sim
+} // ns dht
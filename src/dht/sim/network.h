@@ -0,0 +1,76 @@
+#ifndef DHT_SIM_NETWORK_H_
+#define DHT_SIM_NETWORK_H_
+
+#include <ace/Thread_Mutex.h>
+
+#include <map>
+#include <list>
+#include <string>
+#include <vector>
+
+#include "../key.h"
+#include "../value.h"
+
+namespace dht {
+namespace sim {
+    /**
+     * @class network network.h dht/sim/network.h
+     * @brief In-memory "network" shared by simulated DHT clients
+     * 
+     * Holds the key/value pairs stored by sim::client instances.
+     * Clients that use the same network see each other's values.
+     * The functions are thread safe, so clients running in different
+     * threads can share a network.
+     * 
+     * @see sim::client
+     */
+    class network {
+        typedef std::list<value>                  values_type;
+        typedef std::map<std::string, values_type> store_type;
+        
+        store_type               _store;
+        mutable ACE_Thread_Mutex _m;
+        
+        static network *_instance;
+        
+        static inline std::string _index(const key &k) {
+            return std::string((const char *)k.data(), k.size());
+        }
+    public:
+        network();
+        virtual ~network();
+        
+        /**
+         * @brief Returns the network clients use by default
+         */
+        static network *instance();
+        
+        /**
+         * @brief Stores a value with a key
+         * 
+         * If the key already has a value with the same data, 
+         * its meta data is replaced.
+         */
+        void store(const key &k, const value &v);
+        /**
+         * @brief Gets values stored with a key
+         * @param k        the key
+         * @param result   values are appended here
+         * @param max_hits maximum number of values to append, 0 for all
+         * @return number of values appended
+         */
+        size_t find(const key &k, std::vector<value> *result, 
+                    size_t max_hits = 0) const;
+        /**
+         * @brief Returns number of keys in the network
+         */
+        size_t keys() const;
+        /**
+         * @brief Removes all keys and values
+         */
+        void clear();
+    };
+} // ns sim
+} // ns dht
+
+#endif //DHT_SIM_NETWORK_H_
@@ -0,0 +1,18 @@
+#include "timer_handler.h"
+#include "client.h"
+
+namespace dht {
+namespace sim {
+
+timer_handler::timer_handler(client *owner_client) : _owner(owner_client) {}
+
+timer_handler::~timer_handler() {}
+
+int
+timer_handler::handle_timeout(const ACE_Time_Value &, const void *act) {
+    _owner->_timeout(act);
+    return 0;
+}
+
+} // ns sim
+} // ns dht
@@ -0,0 +1,27 @@
+#ifndef DHT_SIM_TIMER_HANDLER_H_
+#define DHT_SIM_TIMER_HANDLER_H_
+
+#include <ace/Event_Handler.h>
+
+namespace dht {
+namespace sim {
+
+// Forward declaration
+class client;
+
+// Receives the reactor timers of simulated operations and passes
+// them to the client
+class timer_handler : public ACE_Event_Handler {
+    class client *_owner;
+    
+public:
+    timer_handler(class client *owner_client);
+    virtual ~timer_handler();
+    
+    virtual int handle_timeout(const ACE_Time_Value &now, const void *act);
+};
+
+} // ns sim
+} // ns dht
+
+#endif //DHT_SIM_TIMER_HANDLER_H_
@@ -0,0 +1,189 @@
+#ifndef DHT_SMALL_STRING_H_
+#define DHT_SMALL_STRING_H_
+
+#include <stddef.h>
+#include <string.h>
+
+#include <algorithm>
+#include <ostream>
+#include <string>
+
+namespace dht {
+    /**
+     * @class small_string small_string.h dht/small_string.h
+     * @brief A string that keeps short contents inside the object
+     *
+     * Contents of at most N bytes are stored in a buffer inside the
+     * object, longer contents are allocated from the heap. Creating
+     * and copying short strings does not allocate memory. The
+     * contents may contain NULL characters and are always NULL
+     * terminated.
+     */
+    template <size_t N>
+    class small_string {
+    public:
+        const static size_t inline_size = N;
+    private:
+        // Points to _inline or to a heap block
+        char   *_data;
+        size_t  _size;
+        // Bytes that fit in _data, not counting the NULL
+        size_t  _capacity;
+        char    _inline[N + 1];
+
+        inline void _init() {
+            _data      = _inline;
+            _size      = 0;
+            _capacity  = N;
+            _inline[0] = '\0';
+        }
+    public:
+        inline small_string() { _init(); }
+        inline small_string(const char *data, size_t len) {
+            _init();
+            assign(data, len);
+        }
+        inline small_string(const char *str) {
+            _init();
+            assign(str, strlen(str));
+        }
+        inline small_string(const std::string &str) {
+            _init();
+            assign(str.data(), str.size());
+        }
+        inline small_string(const small_string &o) {
+            _init();
+            assign(o._data, o._size);
+        }
+        inline ~small_string() {
+            if (_data != _inline) delete [] _data;
+        }
+
+        inline small_string &operator=(const small_string &o) {
+            if (this != &o) assign(o._data, o._size);
+            return *this;
+        }
+
+        /**
+         * @brief Sets the contents
+         *
+         * data may point to the current contents.
+         */
+        void assign(const char *data, size_t len) {
+            if (len > _capacity) {
+                // data may point to the old block, free it after copying
+                char *n = new char[len + 1];
+                memcpy(n, data, len);
+                if (_data != _inline) delete [] _data;
+                _data     = n;
+                _capacity = len;
+            } else {
+                memmove(_data, data, len);
+            }
+            _size        = len;
+            _data[_size] = '\0';
+        }
+
+        /**
+         * @brief Exchanges the contents with another string
+         *
+         * Heap blocks are exchanged without copying them.
+         */
+        void swap(small_string &o) {
+            if (this == &o) return;
+
+            bool in   = (_data   == _inline);
+            bool o_in = (o._data == o._inline);
+            if (!in && !o_in) {
+                std::swap(_data, o._data);
+            } else if (in && o_in) {
+                char tmp[N + 1];
+                memcpy(tmp,       _inline,   _size   + 1);
+                memcpy(_inline,   o._inline, o._size + 1);
+                memcpy(o._inline, tmp,       _size   + 1);
+            } else {
+                // The inline contents are copied to the other string,
+                // which gives its heap block to this one
+                small_string &i = in ? *this : o;
+                small_string &h = in ? o : *this;
+                char *block = h._data;
+                memcpy(h._inline, i._inline, i._size + 1);
+                h._data = h._inline;
+                i._data = block;
+            }
+            std::swap(_size,     o._size);
+            std::swap(_capacity, o._capacity);
+        }
+
+        inline const char *data()  const { return _data; }
+        inline const char *c_str() const { return _data; }
+        inline size_t      size()  const { return _size; }
+        inline size_t      length() const { return _size; }
+        inline bool        empty() const { return _size == 0; }
+
+        inline std::string str() const { return std::string(_data, _size); }
+        inline operator std::string() const { return str(); }
+
+        /**
+         * @brief Compares the contents like std::string::compare
+         */
+        inline int compare(const char *data, size_t len) const {
+            int r = memcmp(_data, data, std::min(_size, len));
+            if (r != 0) return r;
+            return _size < len ? -1 : (_size > len ? 1 : 0);
+        }
+        inline int compare(const small_string &o) const {
+            return compare(o._data, o._size);
+        }
+        inline int compare(const std::string &s) const {
+            return compare(s.data(), s.size());
+        }
+
+        inline bool operator==(const small_string &o) const {
+            return compare(o) == 0;
+        }
+        inline bool operator!=(const small_string &o) const {
+            return compare(o) != 0;
+        }
+        inline bool operator<(const small_string &o) const {
+            return compare(o) < 0;
+        }
+        inline bool operator==(const std::string &s) const {
+            return compare(s) == 0;
+        }
+        inline bool operator!=(const std::string &s) const {
+            return compare(s) != 0;
+        }
+        inline bool operator==(const char *s) const {
+            return compare(s, strlen(s)) == 0;
+        }
+        inline bool operator!=(const char *s) const {
+            return compare(s, strlen(s)) != 0;
+        }
+    };
+
+    template <size_t N>
+    inline bool operator==(const std::string &s, const small_string<N> &o) {
+        return o == s;
+    }
+    template <size_t N>
+    inline bool operator!=(const std::string &s, const small_string<N> &o) {
+        return o != s;
+    }
+    template <size_t N>
+    inline bool operator==(const char *s, const small_string<N> &o) {
+        return o == s;
+    }
+    template <size_t N>
+    inline bool operator!=(const char *s, const small_string<N> &o) {
+        return o != s;
+    }
+
+    template <size_t N>
+    inline std::ostream &
+    operator<<(std::ostream &os, const small_string<N> &s) {
+        return os.write(s.data(), s.size());
+    }
+} // ns dht
+
+#endif //DHT_SMALL_STRING_H_
@@ -1,6 +1,25 @@
+#include <algorithm>
+
 #include "store_data.h"
 
 namespace dht {
     store_data::~store_data() {
     }   
+    
+    void
+    store_data::swap(store_data &o) {
+        if (this == &o) return;
+        // basic_data::swap drops the digests
+        bool valid   = _digest_valid;
+        bool o_valid = o._digest_valid;
+        basic_data::swap(o);
+        
+        unsigned char tmp[digest_size];
+        memcpy(tmp,       _digest,   digest_size);
+        memcpy(_digest,   o._digest, digest_size);
+        memcpy(o._digest, tmp,       digest_size);
+        _digest_valid   = o_valid;
+        o._digest_valid = valid;
+        std::swap(_allow_hash_transform, o._allow_hash_transform);
+    }
 } // ns dht
@@ -1,6 +1,8 @@
 #ifndef DHT_STORE_DATA_H_
 #define DHT_STORE_DATA_H_
 
+#include <string.h>
+
 #include "basic_data.h"
 
 namespace dht {
@@ -15,9 +17,25 @@ namespace dht {
      * passed key & value must be taken literally or if a one
      * way hash can be performed on them to squeeze the data into
      * something that fits into the DHT.
+     * 
+     * The one way hash (digest) computed by a dht::client 
+     * implementation can be cached in the object, so that storing
+     * or finding the same key again does not compute it again. The
+     * cached digest is copied with the object and dropped when the
+     * data is set.
      */
     class store_data : public basic_data {
+    public:
+        /**
+         * @brief Size of the cached digest in bytes
+         */
+        const static size_t digest_size = 16;
+    private:
         bool _allow_hash_transform;
+        
+        // Cached by const functions of dht::client implementations
+        mutable unsigned char _digest[digest_size];
+        mutable bool          _digest_valid;
 
         // Since this class is not meant to be used by itself,
         // disallow constructor and destructor except by key and value 
@@ -30,6 +48,8 @@ namespace dht {
 
         virtual ~store_data();
         
+        virtual void _changed() { _digest_valid = false; }
+        
         friend class key;
         friend class value;
     public:     
@@ -42,26 +62,61 @@ namespace dht {
          */
         inline void allow_hash_transform(bool a);
         
+        /**
+         * @brief Gets the cached digest of the data
+         * @param d receives digest_size bytes if a digest is cached
+         * @return true if a digest has been cached since the data 
+         *         was last set.
+         */
+        inline bool cached_digest(unsigned char *d) const;
+        /**
+         * @brief Caches a digest of the data
+         * @param d digest_size bytes
+         * 
+         * Used by dht::client implementations. All implementations 
+         * must use the same digest function (MD4). Not thread safe,
+         * the object should not be used by other threads at the 
+         * same time. Since dht::client functions call this for keys 
+         * and values passed by const reference, the same object must
+         * not be passed to them from several threads at once.
+         */
+        inline void cache_digest(const unsigned char *d) const;
+        
+        /**
+         * @brief Exchanges the data, flags and cached digests with 
+         *        another object
+         * 
+         * Used as the move operation, see basic_data::swap().
+         */
+        void swap(store_data &o);
+        
         // inline store_data &operator=(const store_data &o);
     };
     
     inline store_data::store_data(bool aht) : basic_data() { 
         _allow_hash_transform = aht;
+        _digest_valid         = false;
     }
     
     inline store_data::store_data(const void *data, size_t len, bool aht) 
-        : basic_data(data, len) { _allow_hash_transform = aht; }
+        : basic_data(data, len) 
+    { 
+        _allow_hash_transform = aht; 
+        _digest_valid         = false;
+    }
 
     inline store_data::store_data(const char *str, bool aht) 
         : basic_data(str) 
     {
         _allow_hash_transform = aht;
+        _digest_valid         = false;
     }
         
     inline store_data::store_data(const std::string &str, bool aht) 
         : basic_data(str) 
     {
         _allow_hash_transform = aht;
+        _digest_valid         = false;
     }
 
 /*
@@ -73,6 +128,18 @@ namespace dht {
     store_data::allow_hash_transform() const { return _allow_hash_transform; }
     inline void
     store_data::allow_hash_transform(bool a) { _allow_hash_transform = a; }
+    
+    inline bool
+    store_data::cached_digest(unsigned char *d) const {
+        if (!_digest_valid) return false;
+        memcpy(d, _digest, digest_size);
+        return true;
+    }
+    inline void
+    store_data::cache_digest(const unsigned char *d) const {
+        memcpy(_digest, d, digest_size);
+        _digest_valid = true;
+    }
 
 /*    
     inline store_data &store_data::operator=(const store_data &o) {
@@ -0,0 +1,20 @@
+#include "store_many_handler.h"
+
+namespace dht {
+
+store_many_handler::~store_many_handler() {}
+
+void 
+store_many_handler::stored(const dht::key &, const dht::value &, int) {}
+
+void 
+store_many_handler::store_failed(const dht::key &, const dht::value &, 
+                                 int, const char *) {}
+
+void 
+store_many_handler::success() {}
+
+void 
+store_many_handler::failure(int, const char *) {}
+
+} // ns dht
@@ -0,0 +1,51 @@
+#ifndef DHT_STORE_MANY_HANDLER_H_
+#define DHT_STORE_MANY_HANDLER_H_
+
+#include "notify_handler.h"
+#include "key.h"
+#include "value.h"
+
+namespace dht {
+    /**
+     * @class store_many_handler store_many_handler.h dht/store_many_handler.h
+     * @brief Interface for handling results of storing many values at once.
+     * 
+     * Classes that implement this interface get the result of each
+     * key/value pair given to client::store_many() and finally
+     * success() if every pair was stored, or failure() if storing
+     * any of them failed.
+     * 
+     * @see client::store_many()
+     */
+    
+    class store_many_handler : public notify_handler {
+    public:
+        virtual ~store_many_handler();
+
+        /**
+         * @brief Called when a key/value pair has been stored
+         * @param k        the key
+         * @param v        the value
+         * @param replicas number of nodes the value was stored to, 
+         *                 or 0 if the implementation does not know
+         */
+        virtual void stored(const dht::key &k, const dht::value &v,
+                            int replicas);
+
+        /**
+         * @brief Called when storing a key/value pair failed
+         * @param k      the key
+         * @param v      the value
+         * @param error  an error code
+         * @param errstr a NULL terminated string giving exact reason for
+         *               the error
+         */
+        virtual void store_failed(const dht::key &k, const dht::value &v,
+                                  int error, const char *errstr);
+        
+        virtual void success();
+        virtual void failure(int error, const char *errstr);
+    };
+}
+
+#endif //DHT_STORE_MANY_HANDLER_H_
@@ -70,6 +70,18 @@ namespace dht {
          * structure.
          */
         inline const dht::name_value_map &meta() const;
+        
+        /**
+         * @brief Exchanges the contents, including the meta data, with
+         *        another value
+         * 
+         * Moves a value without copying its data or meta data, see
+         * client::store_move().
+         */
+        inline void swap(value &o) { 
+            store_data::swap(o); 
+            _meta.swap(o._meta);
+        }
     };
 
     inline value::value() 
@@ -0,0 +1,36 @@
+#include <string.h>
+
+#include "value_view.h"
+
+namespace dht {
+
+bool
+value_view::meta_next(size_t *pos, const char **name, 
+                      const char **value) const 
+{
+    if (*pos >= _meta_size) return false;
+    *name  = _meta + *pos;
+    *value = *name + strlen(*name) + 1;
+    *pos   = (*value + strlen(*value) + 1) - _meta;
+    return true;
+}
+
+const char *
+value_view::meta(const char *name) const {
+    size_t      pos = 0;
+    const char *n, *v;
+    while (meta_next(&pos, &n, &v))
+        if (!strcmp(n, name)) return v;
+    return NULL;
+}
+
+void
+value_view::copy(value *v) const {
+    v->set(_data, _size);
+    
+    size_t      pos = 0;
+    const char *n, *mv;
+    while (meta_next(&pos, &n, &mv)) v->meta().set(n, mv);
+}
+
+} // ns dht
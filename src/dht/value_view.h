@@ -0,0 +1,77 @@
+#ifndef DHT_VALUE_VIEW_H_
+#define DHT_VALUE_VIEW_H_
+
+#include <stddef.h>
+
+#include "value.h"
+
+namespace dht {
+    /**
+     * @class value_view value_view.h dht/value_view.h
+     * @brief A search result that refers to data owned by the 
+     *        dht::client implementation
+     * 
+     * Given to search_handler::found_view() instead of a dht::value
+     * when the implementation delivers results as views. Nothing is
+     * copied until asked: meta data is looked up from the raw tags 
+     * when meta() is called, and copy() creates a dht::value that 
+     * can be kept.
+     * 
+     * A view, and pointers obtained from it, are valid only during 
+     * the found_view() call it was given to.
+     * 
+     * The meta data is a sequence of NULL terminated name and value
+     * strings: "name1\0value1\0name2\0value2\0".
+     */
+    class value_view {
+        const void *_data;
+        size_t      _size;
+        const char *_meta;
+        size_t      _meta_size;
+    public:
+        /**
+         * @brief Constructs a view of the data and the raw meta data
+         */
+        inline value_view(const void *data,  size_t size,
+                          const char *meta,  size_t meta_size);
+        
+        inline const void *data() const { return _data; }
+        inline size_t      size() const { return _size; }
+        
+        /**
+         * @brief Looks up a meta data value
+         * @param name the name of the meta data
+         * @return the NULL terminated value, or NULL if the name 
+         *         is not found.
+         */
+        const char *meta(const char *name) const;
+        /**
+         * @brief Iterates the meta data
+         * @param pos   position, 0 to start from the first name
+         * @param name  set to the next name
+         * @param value set to its value
+         * @return false if there are no more names
+         * 
+         * Example:
+         * size_t pos = 0; const char *n, *v;
+         * while (view.meta_next(&pos, &n, &v)) ...
+         */
+        bool meta_next(size_t *pos, const char **name, 
+                       const char **value) const;
+        
+        /**
+         * @brief Copies the data and the meta data to a value
+         * 
+         * Sets the data of v and adds the meta data to its meta data.
+         */
+        void copy(value *v) const;
+    };
+    
+    inline value_view::value_view(const void *data,  size_t size,
+                                  const char *meta,  size_t meta_size)
+      : _data(data), _size(size), _meta(meta), _meta_size(meta_size)
+    {
+    }
+} // ns dht
+
+#endif //DHT_VALUE_VIEW_H_
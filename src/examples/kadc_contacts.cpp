@@ -0,0 +1,88 @@
+/**
+ * File: kadc_contacts.cpp
+ * 
+ * Converts KadC contacts between the init file format (kadc.ini)
+ * and the binary contact file format of dht::kadc::contact_file.
+ * 
+ * KadC itself reads only the init file, so a binary contact file
+ * must be converted back before it can be used as init_file.
+ * 
+ * Example:
+ * ./kadc_contacts to-bin kadc.ini kadc.contacts
+ * ./kadc_contacts to-ini kadc.contacts kadc.ini
+ */
+#include <string>
+#include <iostream>
+
+#include <ace/Log_Msg.h>
+#include <ace/OS_NS_string.h>
+
+#include "dht/kadc/contact_file.h"
+
+using dht::kadc::contact_file;
+
+const char *usage = 
+"Usage: kadc_contacts to-bin|to-ini input output";
+
+void
+to_bin(const char *in, const char *out) {
+    contact_file::records_type contacts, blacklisted;
+    std::string                local;
+    
+    contact_file::read_ini(in, &contacts, &blacklisted, &local);
+    contact_file::write(out, contacts, blacklisted, local);
+    
+    std::cout << "Converted " << contacts.size() << " contacts and "
+              << blacklisted.size() << " blacklisted nodes" << std::endl;
+}
+
+void
+to_ini(const char *in, const char *out) {
+    contact_file f;
+    f.open(in);
+    
+    contact_file::records_type contacts(f.contact(0), 
+                                        f.contact(f.contacts()));
+    contact_file::records_type blacklisted(f.blacklisted(0),
+                                           f.blacklisted(f.blacklisted()));
+    contact_file::write_ini(out, contacts, blacklisted, f.local());
+    
+    std::cout << "Converted " << contacts.size() << " contacts and "
+              << blacklisted.size() << " blacklisted nodes" << std::endl;
+}
+
+int
+do_main(int argc, ACE_TCHAR *argv[]) {
+    if (argc != 4)
+        throw "Invalid number of arguments";
+    
+    if      (!ACE_OS::strcmp(argv[1], "to-bin")) to_bin(argv[2], argv[3]);
+    else if (!ACE_OS::strcmp(argv[1], "to-ini")) to_ini(argv[2], argv[3]);
+    else throw "Unknown conversion";
+    
+    return 0;
+}
+
+int
+ACE_TMAIN (int argc, ACE_TCHAR *argv[])
+{
+    if (argc <= 1) {
+        std::cerr << usage << std::endl;
+        return -1;
+    }
+    
+    try {
+        do_main(argc, argv);
+    } catch (std::exception &e) {
+        ACE_ERROR((LM_ERROR, "Exception caught:\n"));
+        ACE_ERROR((LM_ERROR, "%s\n", e.what()));
+        ACE_ERROR((LM_ERROR, usage));
+        return -1;
+    } catch (const char *err) {
+        std::cerr << "Error: " << err << std::endl;
+        std::cerr << usage << std::endl;
+        return -1;
+    }
+
+    return 0;
+}
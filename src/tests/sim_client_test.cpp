@@ -0,0 +1,175 @@
+/**
+ * File: sim_client_test.cpp
+ *
+ * Tests of the simulated DHT client (dht::sim::client) that need no
+ * network. Built and run with 'scons test'.
+ *
+ * Each test connects a client, starts operations and lets the
+ * reactor run them. The handlers disconnect the client in the middle
+ * of delivering results, which aborts the operation that is being
+ * delivered.
+ */
+#include <stdio.h>
+
+#include <vector>
+
+#include "dht/search_handler.h"
+#include "dht/store_many_handler.h"
+#include "dht/sim/client.h"
+#include "dht/sim/network.h"
+
+static int failures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", \
+                    __FILE__, __LINE__, #cond); \
+            failures++; \
+        } \
+    } while (0)
+
+// Disconnects when the given result is found
+class disconnect_on_found : public dht::search_handler {
+    dht::client *_client;
+    int          _at;
+public:
+    int found_calls;
+    int success_calls;
+    int failure_calls;
+    int finished_calls;
+
+    disconnect_on_found(dht::client *c, int at)
+      : _client(c), _at(at), found_calls(0), success_calls(0),
+        failure_calls(0), finished_calls(0) {}
+
+    virtual int found(const dht::key &, const dht::value &) {
+        if (++found_calls == _at) _client->disconnect();
+        return 0;
+    }
+    virtual void success(const dht::key &) { success_calls++; }
+    virtual void failure(const dht::key &, int, const char *) {
+        failure_calls++;
+    }
+    virtual void finished() { finished_calls++; }
+};
+
+// Disconnects when the first pair has been stored
+class disconnect_on_stored : public dht::store_many_handler {
+    dht::client *_client;
+public:
+    int stored_calls;
+    int success_calls;
+    int failure_calls;
+
+    disconnect_on_stored(dht::client *c)
+      : _client(c), stored_calls(0), success_calls(0), failure_calls(0) {}
+
+    virtual void stored(const dht::key &, const dht::value &, int) {
+        if (++stored_calls == 1) _client->disconnect();
+    }
+    virtual void success() { success_calls++; }
+    virtual void failure(int, const char *) { failure_calls++; }
+};
+
+static void
+run_until(dht::client *c, int state) {
+    for (int i = 0; i < 1000 && c->in_state() != state; i++) {
+        dht::time_value_type wait(0, 10 * 1000);
+        c->process(wait);
+    }
+}
+
+static void
+connect(dht::sim::client *c) {
+    dht::name_value_map opts;
+    opts.set("latency",         "1");
+    opts.set("connect_latency", "1");
+    c->init(opts);
+    c->connect();
+    run_until(c, dht::client::connected);
+    CHECK(c->in_state() == dht::client::connected);
+}
+
+static void
+test_find_disconnect() {
+    dht::sim::network::instance()->clear();
+    dht::key k("find key");
+    for (int i = 0; i < 5; i++) {
+        char data[16];
+        sprintf(data, "value %d", i);
+        dht::sim::network::instance()->store(k, dht::value(data));
+    }
+
+    dht::sim::client c;
+    connect(&c);
+    disconnect_on_found h(&c, 2);
+    c.find(k, &h);
+    run_until(&c, dht::client::disconnected);
+
+    // The rest of the results are not delivered, and the search ends
+    // with the failure from the disconnect
+    CHECK(c.in_state() == dht::client::disconnected);
+    CHECK(h.found_calls   == 2);
+    CHECK(h.failure_calls == 1);
+    CHECK(h.success_calls == 0);
+}
+
+static void
+test_find_many_disconnect() {
+    dht::sim::network::instance()->clear();
+    std::vector<dht::key> keys;
+    keys.push_back(dht::key("key 1"));
+    keys.push_back(dht::key("key 2"));
+    keys.push_back(dht::key("key 3"));
+    for (size_t i = 0; i < keys.size(); i++) {
+        dht::sim::network::instance()->store(keys[i], dht::value("a"));
+        dht::sim::network::instance()->store(keys[i], dht::value("b"));
+    }
+
+    dht::sim::client c;
+    connect(&c);
+    disconnect_on_found h(&c, 1);
+    c.find_many(&keys[0], &keys[0] + keys.size(), &h);
+    run_until(&c, dht::client::disconnected);
+
+    CHECK(c.in_state() == dht::client::disconnected);
+    CHECK(h.found_calls    == 1);
+    CHECK(h.failure_calls  == 1);
+    CHECK(h.finished_calls == 0);
+}
+
+static void
+test_store_many_disconnect() {
+    dht::sim::network::instance()->clear();
+    std::vector<dht::client::key_value> items;
+    items.push_back(dht::client::key_value(dht::key("key 1"),
+                                           dht::value("a")));
+    items.push_back(dht::client::key_value(dht::key("key 2"),
+                                           dht::value("b")));
+
+    dht::sim::client c;
+    connect(&c);
+    disconnect_on_stored h(&c);
+    c.store_many(&items[0], &items[0] + items.size(), &h);
+    run_until(&c, dht::client::disconnected);
+
+    CHECK(c.in_state() == dht::client::disconnected);
+    CHECK(h.stored_calls  == 1);
+    CHECK(h.failure_calls == 1);
+    CHECK(h.success_calls == 0);
+}
+
+int
+main(int, char *[]) {
+    test_find_disconnect();
+    test_find_many_disconnect();
+    test_store_many_disconnect();
+
+    if (failures) {
+        fprintf(stderr, "sim_client_test: %d checks failed\n", failures);
+        return 1;
+    }
+    printf("sim_client_test: all tests passed\n");
+    return 0;
+}